@@ -1,7 +1,11 @@
 #include <algorithm>
+#include <memory>
+#include <fstream>
 
 #include "Application.h"
 #include "Image.h"
+#include "Lockstep.h"
+#include "Machine.h"
 #include "lib.h"
 
 #define MXT_TERMINAL_TITLE "Z80 Terminal"
@@ -32,11 +36,30 @@
 #define CMD_SET "set"
 #define CMD_INT "int"
 #define CMD_BREAK "break"
+#define CMD_WATCH "watch"
 #define CMD_OPEN "open"
 #define CMD_CLEAR "clear"
+#define CMD_BENCH "bench"
+#define CMD_DISPATCH "dispatch"
+#define CMD_LOCKSTEP "lockstep"
+#define CMD_SAVE "save"
+#define CMD_RESTORE "restore"
+#define CMD_HISTORY "history"
+#define CMD_BACK "back"
+#define CMD_REWIND "rewind"
+#define CMD_TRACE "trace"
+#define CMD_PROFILE "profile"
+#define CMD_SPEED "speed"
 
 #define MXT_ICON_PATH "z80.bmp"
 
+#define MXT_CPU_SLICE 50000
+#define MXT_UI_PERIOD 1000
+#define MXT_FRAME_PERIOD (1000000/60)
+#define MXT_FRAME_CYCLES (Z80::CLOCK/60)
+#define MXT_BENCH_COUNT 10000000
+#define MXT_PROFILE_LINES 20
+
 namespace z80 {
 
 using winui::Manager;
@@ -45,8 +68,8 @@ using winui::Image;
 using winui::Color;
 
 Application::Application(void)
-	: wScreen(mScreen, mKeyboard)
-	, wStatus(mCPU)
+	: wScreen(mFrames)
+	, wStatus(mFrames, mDisassembly)
 	, wTerminal(MXT_TERMINAL_TITLE, Dimension(MXT_COLS, MXT_ROWS), Image(MXT_CHARSET_PATH), Dimension(MXT_CHAR_W, MXT_CHAR_H), MXT_CHARSET_COLORSPACE)
 {
 	reset();
@@ -55,15 +78,24 @@ Application::Application(void)
 	mCPU.registerPeripheral(0x10, mScreen);
 	mCPU.registerPeripheral(0x20, mKeyboard);
 
+	mVSync.set(false);
+
 	mStatus.onInt([this]( ) { mCPU.interrupt(); });
-	mStatus.registerInt(0x01, wScreen.int60fps());
+	mStatus.registerInt(0x01, mVSync);
 	mStatus.registerInt(0x02, mKeyboard.keyPressedInt());
 	mStatus.registerInt(0xFF, manualInt);
 
+	// the screen timer runs off the guest's clock, not the host's
+	mCPU.getEvents().schedule([this]( ) { if(mScreen.timer_en()) mVSync.set(true); }, MXT_FRAME_CYCLES, mCPU.getCycles());
+
+	mSchedule.setBulk([this]( ) { return tick(); });
+	mSchedule.schedule([this]( ) { job_fn f; while(mCommands.pop(f)) f(); mGovernor.measure(mCPU.getCycles()); }, MXT_UI_PERIOD);
+	mSchedule.schedule([this]( ) { publish(); }, MXT_FRAME_PERIOD);
 
-	mSchedule.schedule([this]( ) { tick(); }, 1);
-	mSchedule.schedule([]( ) { Manager::instance().tick(); }, 1);
-	mSchedule.schedule([]( ) { Manager::instance().render(); }, 1000000/60);
+	mUI.schedule([this]( ) { job_fn f; while(mOutput.pop(f)) f(); Manager::instance().tick(); closeAllHidden(wWindows); }, MXT_UI_PERIOD);
+	mUI.schedule([this]( ) { mFrames.acquire(); Manager::instance().render(); }, MXT_FRAME_PERIOD);
+
+	wScreen.setKeyCallback([this](uint k, bool down) { toCPU([this, k, down]( ) { mKeyboard.press(k, down); }); });
 
 	wTerminal.setPrompt(MXT_TERMINAL_PROMPT);
 	wTerminal.setDefaultColor(Color::BLACK());
@@ -82,15 +114,27 @@ Application::Application(void)
 	mInstructions[CMD_SET]   = &Application::set;
 	mInstructions[CMD_INT]   = &Application::interrupt;
 	mInstructions[CMD_BREAK] = &Application::setBreak;
+	mInstructions[CMD_WATCH] = &Application::watch;
 	mInstructions[CMD_OPEN]  = &Application::open;
 	mInstructions[CMD_CLEAR] = &Application::clear;
+	mInstructions[CMD_BENCH] = &Application::bench;
+	mInstructions[CMD_DISPATCH] = &Application::dispatch;
+	mInstructions[CMD_LOCKSTEP] = &Application::lockstep;
+	mInstructions[CMD_SAVE] = &Application::save;
+	mInstructions[CMD_RESTORE] = &Application::restore;
+	mInstructions[CMD_HISTORY] = &Application::history;
+	mInstructions[CMD_BACK] = &Application::back;
+	mInstructions[CMD_REWIND] = &Application::rewind;
+	mInstructions[CMD_TRACE] = &Application::trace;
+	mInstructions[CMD_PROFILE] = &Application::profile;
+	mInstructions[CMD_SPEED] = &Application::speed;
 
 #define MAKE_SET(R) \
 std::make_pair( \
 TokenType::NUMBER, \
 [this](const Tokenizer::Token& t) { \
 mCPU.set##R (t.value); \
-wTerminal.println(lib::stringf("Setting " #R " to $%04X", t.value)); \
+print(lib::stringf("Setting " #R " to $%04X", t.value)); \
 })
 	mSetFunctions["pc"] = MAKE_SET(PC);
 	mSetFunctions["sp"] = MAKE_SET(SP);
@@ -103,8 +147,9 @@ wTerminal.println(lib::stringf("Setting " #R " to $%04X", t.value)); \
 #undef MAKE_SET
 
 	cpu_running = false;
+	mRunning = false;
 
-	wLog.println("Z80 Simulation Environment");
+	log("Z80 Simulation Environment");
 }
 
 Application::~Application(void)
@@ -113,13 +158,35 @@ Application::~Application(void)
 
 void Application::run(void)
 {
+	publish();
+	mFrames.acquire();
+
+	mRunning = true;
+	mThread.reset(new lib::Thread([this]( ) { emulate(); }));
+
 	while(Manager::instance().isRunning())
 	{
-		mSchedule.step();
+		mUI.step();
 	}
+
+	mRunning = false;
+	mThread->join();
 }
 
 void Application::execute(const std::string& cmd)
+{
+	toCPU([this, cmd]( ) { command(cmd); });
+}
+
+void Application::emulate(void)
+{
+	while(mRunning)
+	{
+		mSchedule.step();
+	}
+}
+
+void Application::command(const std::string& cmd)
 {
 	try
 	{
@@ -145,41 +212,112 @@ void Application::execute(const std::string& cmd)
 	}
 	catch(const std::string& e)
 	{
-		wTerminal.println("ERR: " + e);
+		print("ERR: " + e);
 	}
 }
 
-void Application::tick(void)
+// Runs the cpu for a slice, in between the UI events, as far as the
+// governor lets it. Returns how long there is nothing to do.
+uint64_t Application::tick(void)
 {
-	if(cpu_running)
+	if(!cpu_running)
 	{
-		uint32_t skip = skipBP_;
+		return lib::Schedule::IDLE;
+	}
 
-		skipBP_ = 0x10000;
+	uint64_t wait = 0;
+	uint64_t n = std::min<uint64_t>(MXT_CPU_SLICE, mGovernor.getBudget(mCPU.getCycles(), wait));
 
-		for(const auto& p : breakPoints)
-		{
-			if(mCPU.getPC() != skip && mCPU.getPC() == p)
-			{
-				cpu_running = false;
-				wTerminal.println(lib::stringf("BREAK @$%04X: %s", p, mCPU.disassemble(p).c_str()));
-				return;
-			}
-		}
+	if(!n)
+	{
+		return wait;
+	}
+
+	try
+	{
+		Z80::Stop s = mCPU.runFor(n);
 
-		try
+		if(s == Z80::Stop::BREAK)
 		{
-			mCPU.execute();
+			uint16_t p = mCPU.getPC();
+
+			cpu_running = false;
+			print(lib::stringf("BREAK @$%04X: %s", p, mCPU.disassemble(p).c_str()));
 		}
-		catch(const std::string& err)
+		else if(s == Z80::Stop::WATCH)
 		{
+			const Watchpoints::Hit& h(mCPU.getWatchpoints().getHit());
+			uint16_t p = mCPU.getPC();
+			std::string where(h.port ? lib::stringf("port $%02X", h.addr) : lib::stringf("$%04X", h.addr));
+
 			cpu_running = false;
-			wLog.println("CPU crashed. Error:");
-			wLog.println(err);
+			print(lib::stringf("WATCH #%u: %s $%02X %s %s, stopped @$%04X: %s",
+				h.id, h.write ? "wrote" : "read", h.value, h.write ? "to" : "from", where.c_str(), p, mCPU.disassemble(p).c_str()));
 		}
+
+		// only an interrupt from the UI can wake a halted cpu without events
+		if(s == Z80::Stop::HALT && mCPU.getEvents().next() == Events::NEVER)
+		{
+			return lib::Schedule::IDLE;
+		}
+
+		return cpu_running ? 0 : lib::Schedule::IDLE;
+	}
+	catch(const std::string& err)
+	{
+		cpu_running = false;
+		log("CPU crashed. Error:");
+		log(err);
 	}
 
-	closeAllHidden(wWindows);
+	return lib::Schedule::IDLE;
+}
+
+// Hands a copy of everything the windows show to the UI thread.
+void Application::publish(void)
+{
+	Frames::Frame& f(mFrames.back());
+
+	f.cpu = mCPU;
+	f.screen = mScreen;
+	f.heat.resize(mProfiler ? 0x10000 : 0);
+	f.speed = mGovernor.toString();
+	f.mhz = mGovernor.getMHz();
+	f.history = static_cast<bool>(mRewind);
+
+	for(uint a = 0 ; a < f.heat.size() ; ++a)
+	{
+		f.heat[a] = mProfiler->getHeat(a);
+	}
+
+	mFrames.publish();
+}
+
+void Application::toCPU(job_fn f)
+{
+	while(!mCommands.push(f))
+	{
+		SDL_Delay(1);
+	}
+}
+
+// Output is dropped once the UI has shut down.
+void Application::toUI(job_fn f)
+{
+	while(!mOutput.push(f) && mRunning)
+	{
+		SDL_Delay(1);
+	}
+}
+
+void Application::print(const std::string& s)
+{
+	toUI([this, s]( ) { wTerminal.println(s); });
+}
+
+void Application::log(const std::string& s)
+{
+	toUI([this, s]( ) { wLog.println(s); });
 }
 
 void Application::reset(void)
@@ -191,37 +329,51 @@ void Application::reset(void)
 	cpu_running = false;
 }
 
+// An edit from the RAM monitor goes into the history like a write of
+// the cpu would, so that stepping back past it undoes it.
+void Application::edit(uint16_t a, uint8_t v)
+{
+	if(mRewind) mRewind->write(a, mCPU.peek(a));
+
+	mCPU.poke(a, v);
+}
+
 void Application::createRAMMonitor(uint16_t a, uint s)
 {
 	RAMMonitor *wRAM = new RAMMonitor(s < 0x100 ? 0x100 : s);
-	wRAM->setAccess([this](uint16_t a) -> uint8_t& { return mCPU.RAM(a); });
+	wRAM->setAccess(
+		[this](uint16_t a) -> uint8_t { return mFrames.front().cpu.peek(a); },
+		[this](uint16_t a, uint8_t v) { toCPU([this, a, v]( ) { edit(a, v); }); });
 	wRAM->setAddress(a);
 	wWindows.push_back(wRAM);
 }
 
 void Application::createDisassembler(uint16_t a)
 {
-	DeassemblerWindow *wDeASM = new DeassemblerWindow(mCPU);
+	DeassemblerWindow *wDeASM = new DeassemblerWindow(mFrames, mDisassembly);
 	wDeASM->setBreakPointCallback(std::make_pair(
-		[this](uint16_t a) -> bool { return std::find(breakPoints.begin(), breakPoints.end(), a) != breakPoints.end(); },
-		[this](uint16_t a) -> void { toggleBreakpoint(a); }));
+		[this](uint16_t a) -> bool { return mFrames.front().cpu.getBreakpoints().test(a); },
+		[this](uint16_t a) -> void { toCPU([this, a]( ) { toggleBreakpoint(a); }); }));
+	wDeASM->setStepBackCallback([this]( ) -> bool
+		{
+			if(!mFrames.front().history) return false;
+			toCPU([this]( ) { if(mRewind) mRewind->back(); });
+			return true;
+		});
+	wDeASM->setHeatCallback([this](uint16_t a) -> uint { const auto& h(mFrames.front().heat); return h.empty() ? 0 : h[a]; });
 	wDeASM->setAddress(a);
 	wWindows.push_back(wDeASM);
 }
 
 void Application::toggleBreakpoint(uint16_t p)
 {
-	auto i = std::find(breakPoints.begin(), breakPoints.end(), p);
-
-	if(i == breakPoints.end())
+	if(mCPU.getBreakpoints().toggle(p))
 	{
-		breakPoints.push_back(p);
-		wTerminal.println(lib::stringf("Added breakpoint @$%04X", p));
+		print(lib::stringf("Added breakpoint @$%04X", p));
 	}
 	else
 	{
-		breakPoints.erase(i);
-		wTerminal.println(lib::stringf("Removed breakpoint @$%04X", p));
+		print(lib::stringf("Removed breakpoint @$%04X", p));
 	}
 }
 
@@ -229,8 +381,8 @@ void Application::toggleBreakpoint(uint16_t p)
 
 void Application::quit(const Tokenizer& t)
 {
-	wTerminal.println("Shutting down ...");
-	Manager::instance().stop();
+	print("Shutting down ...");
+	toUI([]( ) { Manager::instance().stop(); });
 }
 
 void Application::load(const Tokenizer& t)
@@ -250,22 +402,37 @@ void Application::load(const Tokenizer& t)
 	std::string fn(t[1].token);
 	Program prg(fn);
 
-	wTerminal.println(lib::stringf("Loading \"%s\" [%uB] @$%04X ...", fn.c_str(), prg.length(), addr));
+	print(lib::stringf("Loading \"%s\" [%uB] @$%04X ...", fn.c_str(), prg.length(), addr));
 
 	mCPU.loadRAM(addr, prg);
+
+	// replaying the history would run into the new program
+	if(mRewind) mRewind->clear();
+
+	std::string sym(Symbols::getPath(fn));
+
+	if(std::ifstream(sym))
+	{
+		mSymbols.load(sym);
+		print(lib::stringf("Loaded %u symbols from \"%s\".", mSymbols.size(), sym.c_str()));
+	}
+	else
+	{
+		mSymbols.clear();
+	}
 }
 
 void Application::reset(const Tokenizer& t)
 {
-	wTerminal.println("Resetting CPU.");
+	print("Resetting CPU.");
 	reset();
 }
 
 void Application::start(const Tokenizer& t)
 {
-	wTerminal.println(lib::stringf("Start running @$%04X", mCPU.getPC()));
+	print(lib::stringf("Start running @$%04X", mCPU.getPC()));
 	cpu_running = true;
-	skipBP_ = mCPU.getPC();
+	mGovernor.sync(mCPU.getCycles());
 }
 
 void Application::stop(const Tokenizer& t)
@@ -275,7 +442,7 @@ void Application::stop(const Tokenizer& t)
 
 void Application::step(const Tokenizer& t)
 {
-	wTerminal.println(lib::stringf("Executing @$%04X: %s", mCPU.getPC(), mCPU.disassemble(mCPU.getPC()).c_str()));
+	print(lib::stringf("Executing @$%04X: %s", mCPU.getPC(), mCPU.disassemble(mCPU.getPC()).c_str()));
 	mCPU.execute();
 }
 
@@ -285,7 +452,7 @@ void Application::help(const Tokenizer& t)
 	{
 		for(const auto& p : mInstructions)
 		{
-			wTerminal.println(p.first);
+			print(p.first);
 		}
 	}
 }
@@ -324,37 +491,175 @@ void Application::interrupt(const Tokenizer& t)
 	}
 }
 
+// A plain address toggles its breakpoint; one with a hit count or a
+// condition (re)sets it.
 void Application::setBreak(const Tokenizer& t)
 {
-	if(t.size() != 2)
+	Breakpoints& b(mCPU.getBreakpoints());
+
+	if(t.size() < 2)
 	{
-		throw std::string("BREAK CLEAR|LIST|$ADDR");
+		throw std::string("BREAK CLEAR|LIST|$ADDR [COUNT N] [IF COND]");
 	}
 
 	if(t[1].type == TokenType::NUMBER)
 	{
-		toggleBreakpoint(t[1].value);
-	}
-	else if(t[1].type == TokenType::LITERAL)
-	{
-		if(t[1].token == "clear")
+		if(t[1].value > 0xFFFF)
 		{
-			wTerminal.println(lib::stringf("Removed all %u breakpoints.", breakPoints.size()));
-			breakPoints.clear();
+			throw std::string("Invalid breakpoint address!");
+		}
+
+		if(t.size() == 2)
+		{
+			toggleBreakpoint(t[1].value);
+
+			return;
 		}
-		else if(t[1].token == "list")
+
+		Breakpoints::Condition c { Expression(), 1, 0 };
+		uint i = 2;
+
+		if(t[i].type == TokenType::LITERAL && t[i].token == "count")
 		{
-			wTerminal.println("Breakpoints:");
-			for(const auto& p : breakPoints)
+			if(i + 1 >= t.size() || t[i + 1].type != TokenType::NUMBER || !t[i + 1].value)
 			{
-				wTerminal.println(lib::stringf("@$%04X", p));
+				throw std::string("Invalid hit count!");
 			}
+
+			c.count = t[i + 1].value;
+			i += 2;
 		}
-		else
+
+		if(i < t.size())
 		{
-			throw std::string("Invalid argument '" + t[1].token + "' to command 'BREAK'!");
+			if(t[i].type != TokenType::LITERAL || t[i].token != "if")
+			{
+				throw std::string("BREAK $ADDR [COUNT N] [IF COND]");
+			}
+
+			c.expr = Expression(t, i + 1);
 		}
+
+		b.set(t[1].value, c);
+
+		print(lib::stringf("Added breakpoint @$%04X", t[1].value));
+	}
+	else if(t.size() == 2 && t[1].type == TokenType::LITERAL && t[1].token == "clear")
+	{
+		print(lib::stringf("Removed all %u breakpoints.", b.size()));
+		b.clear();
 	}
+	else if(t.size() == 2 && t[1].type == TokenType::LITERAL && t[1].token == "list")
+	{
+		print("Breakpoints:");
+		for(uint16_t p : b.list())
+		{
+			const Breakpoints::Condition *c = b.getCondition(p);
+
+			if(!c)
+			{
+				print(lib::stringf("@$%04X", p));
+			}
+			else
+			{
+				print(lib::stringf("@$%04X: %u/%u hits%s%s", p, c->hits, c->count,
+					c->expr.empty() ? "" : " if ", c->expr.toString().c_str()));
+			}
+		}
+	}
+	else
+	{
+		throw std::string("Invalid argument '" + t[1].token + "' to command 'BREAK'!");
+	}
+}
+
+void Application::watch(const Tokenizer& t)
+{
+	static const char * const modes[] = { "", "read", "write", "access" };
+
+	Watchpoints& w(mCPU.getWatchpoints());
+
+	if(t.size() == 1 || (t.size() == 2 && t[1].type == TokenType::LITERAL && t[1].token == "list"))
+	{
+		print("Watchpoints:");
+		for(const auto& e : w.getWatches())
+		{
+			print(lib::stringf("#%u: %s %s$%04X-$%04X%s%s", e.id, modes[e.mode], e.port ? "port " : "", e.from, e.to,
+				e.expr.empty() ? "" : " if ", e.expr.toString().c_str()));
+		}
+
+		return;
+	}
+
+	if(t.size() == 2 && t[1].type == TokenType::LITERAL && t[1].token == "clear")
+	{
+		print(lib::stringf("Removed all %u watchpoints.", (uint) w.getWatches().size()));
+		w.clear();
+
+		return;
+	}
+
+	if(t.size() == 3 && t[1].type == TokenType::LITERAL && t[1].token == "delete" && t[2].type == TokenType::NUMBER)
+	{
+		if(!w.remove(t[2].value))
+		{
+			throw lib::stringf("No watchpoint #%u!", t[2].value);
+		}
+
+		print(lib::stringf("Removed watchpoint #%u.", t[2].value));
+
+		return;
+	}
+
+	uint i = 1, m = Watchpoints::ACCESS, n = t.size();
+	bool port = false;
+	Expression cond;
+
+	for(uint j = 1 ; j < t.size() ; ++j)
+	{
+		if(t[j].type == TokenType::LITERAL && t[j].token == "if")
+		{
+			cond = Expression(t, j + 1);
+			n = j;
+
+			break;
+		}
+	}
+
+	if(i < n && t[i].type == TokenType::LITERAL && t[i].token == "port")
+	{
+		port = true;
+		++i;
+	}
+
+	if(i < n && t[i].type == TokenType::LITERAL)
+	{
+		auto j = std::find(std::begin(modes) + 1, std::end(modes), t[i].token);
+
+		if(j == std::end(modes))
+		{
+			throw std::string("Invalid watch mode '" + t[i].token + "'!");
+		}
+
+		m = j - std::begin(modes);
+		++i;
+	}
+
+	if(i >= n || n > i + 2 || t[i].type != TokenType::NUMBER || (i + 1 < n && t[i + 1].type != TokenType::NUMBER))
+	{
+		throw std::string("WATCH [PORT] [READ|WRITE|ACCESS] $FROM [$TO] [IF COND]|DELETE ID|CLEAR|LIST");
+	}
+
+	uint from = t[i].value, to = (i + 1 < n) ? t[i + 1].value : from;
+
+	if(from > to || to > (port ? 0xFFu : 0xFFFFu))
+	{
+		throw std::string("Invalid watch range!");
+	}
+
+	uint id = w.add(port, from, to, m, cond);
+
+	print(lib::stringf("Added watchpoint #%u on %s of %s$%04X-$%04X.", id, modes[m], port ? "port " : "", from, to));
 }
 
 void Application::open(const Tokenizer& t)
@@ -366,7 +671,7 @@ void Application::open(const Tokenizer& t)
 
 	if(t[1].token == "screen")
 	{
-		wScreen.show();
+		toUI([this]( ) { wScreen.show(); });
 	}
 	else if(t[1].token == "ram")
 	{
@@ -383,7 +688,7 @@ void Application::open(const Tokenizer& t)
 			s = t[3].value;
 		}
 
-		createRAMMonitor(a, s);
+		toUI([this, a, s]( ) { createRAMMonitor(a, s); });
 
 	}
 	else if(t[1].token == "dis")
@@ -395,7 +700,7 @@ void Application::open(const Tokenizer& t)
 			a = t[2].value;
 		}
 
-		createDisassembler(a);
+		toUI([this, a]( ) { createDisassembler(a); });
 	}
 	else
 	{
@@ -405,8 +710,316 @@ void Application::open(const Tokenizer& t)
 
 void Application::clear(const Tokenizer& t)
 {
-	wTerminal.println("Clearing RAM and registers.");
+	print("Clearing RAM and registers.");
 	mCPU.clear();
+
+	// replaying the history would run into the wiped RAM
+	if(mRewind) mRewind->clear();
+}
+
+void Application::bench(const Tokenizer& t)
+{
+	uint n = MXT_BENCH_COUNT;
+
+	if(t.size() >= 2 && t[1].type == TokenType::NUMBER)
+	{
+		n = t[1].value;
+	}
+
+	if(!n)
+	{
+		throw std::string("BENCH [COUNT]");
+	}
+
+	// Both engines run the loaded program on a detached copy of the cpu, so
+	// the peripherals and the real machine state are left untouched.
+	auto measure = [this, n](Z80::Dispatch d) -> double
+	{
+		std::unique_ptr<Z80> cpu(new Z80(mCPU));
+		Timer timer;
+
+		cpu->clearPeripherals();
+		cpu->getBreakpoints().clear();
+		cpu->getWatchpoints().clear();
+		cpu->setDispatch(d);
+		timer.reset();
+
+		for(uint i = 0 ; i < n ; )
+		{
+			if(cpu->isHalted()) cpu->restart();
+			i += cpu->step();
+		}
+
+		return n / (double) std::max<long>(timer.get().count(), 1);
+	};
+
+	print(lib::stringf("Benchmarking %u instructions @$%04X ...", n, mCPU.getPC()));
+
+	double sw = measure(Z80::Dispatch::SWITCH);
+	double tb = measure(Z80::Dispatch::TABLE);
+	double bl = measure(Z80::Dispatch::BLOCK);
+	double jt = measure(Z80::Dispatch::JIT);
+
+	print(lib::stringf("switch: %.1f MIPS", sw));
+	print(lib::stringf("table:  %.1f MIPS (%+.1f%%)", tb, (tb / sw - 1.0) * 100.0));
+	print(lib::stringf("block:  %.1f MIPS (%+.1f%%)", bl, (bl / sw - 1.0) * 100.0));
+	print(lib::stringf("jit:    %.1f MIPS (%+.1f%%)", jt, (jt / sw - 1.0) * 100.0));
+}
+
+void Application::dispatch(const Tokenizer& t)
+{
+	static const char * const names[] = { "switch", "table", "block", "jit" };
+
+	if(t.size() >= 2)
+	{
+		if(t[1].type != TokenType::LITERAL)
+		{
+			throw std::string("DISPATCH [SWITCH|TABLE|BLOCK|JIT]");
+		}
+
+		auto i = std::find(std::begin(names), std::end(names), t[1].token);
+
+		if(i == std::end(names))
+		{
+			throw std::string("Unknown dispatch engine '" + t[1].token + "'!");
+		}
+
+		mCPU.setDispatch(static_cast<Z80::Dispatch>(i - std::begin(names)));
+	}
+
+	print(lib::stringf("Dispatch: %s (%u cached blocks, %llu native instructions)",
+		names[static_cast<uint>(mCPU.getDispatch())], mCPU.getCachedBlocks(), (unsigned long long) mCPU.getNativeInstructions()));
+}
+
+void Application::lockstep(const Tokenizer& t)
+{
+	uint64_t n = MXT_BENCH_COUNT;
+
+	if(t.size() >= 2 && t[1].type == TokenType::NUMBER)
+	{
+		n = t[1].value;
+	}
+
+	print(lib::stringf("Comparing JIT and interpreter for %llu instructions @$%04X ...", (unsigned long long) n, mCPU.getPC()));
+
+	LockstepResult r = z80::lockstep(mCPU, n);
+
+	print(lib::stringf("No divergence; %llu of %llu instructions ran natively.",
+		(unsigned long long) r.native, (unsigned long long) r.instructions));
+}
+
+// Same layout as Machine, so the headless runner can pick up from here.
+void Application::save(const Tokenizer& t)
+{
+	if(t.size() != 2 || t[1].type != TokenType::STRING)
+	{
+		throw std::string("SAVE \"FILE.SNA\"");
+	}
+
+	Snapshot s;
+
+	mCPU.save(s);
+	mScreen.save(s);
+	mKeyboard.save(s);
+	mStatus.save(s);
+	s.save(t[1].token);
+
+	print(lib::stringf("Saved snapshot \"%s\" [%uB] @$%04X.", t[1].token.c_str(), (uint) s.size(), mCPU.getPC()));
+}
+
+void Application::restore(const Tokenizer& t)
+{
+	if(t.size() != 2 || t[1].type != TokenType::STRING)
+	{
+		throw std::string("RESTORE \"FILE.SNA\"");
+	}
+
+	Snapshot s;
+
+	s.load(t[1].token);
+
+	// a corrupt snapshot must not leave the machine half restored
+	Machine::check(s);
+
+	s.rewind();
+	mCPU.restore(s);
+	mScreen.restore(s);
+	mKeyboard.restore(s);
+	mStatus.restore(s);
+
+	cpu_running = false;
+
+	print(lib::stringf("Restored snapshot \"%s\" @$%04X.", t[1].token.c_str(), mCPU.getPC()));
+
+	// the recorded history belongs to the state we just left
+	if(mRewind) mRewind->clear();
+}
+
+void Application::history(const Tokenizer& t)
+{
+	if(t.size() >= 2 && t[1].type == TokenType::LITERAL && t[1].token == "off")
+	{
+		mRewind.reset();
+		print("Stopped recording history.");
+	}
+	else if(t.size() == 1 || t[1].type == TokenType::NUMBER)
+	{
+		size_t n = t.size() >= 2 ? t[1].value : Rewind::STEPS;
+
+		mRewind.reset();
+		mRewind.reset(new Rewind(mCPU, n));
+		mRewind->setHandlers(
+			[this](Snapshot& s) { mCPU.save(s); mScreen.save(s); mKeyboard.save(s); mStatus.save(s); },
+			[this](Snapshot& s) { mCPU.restore(s); mScreen.restore(s); mKeyboard.restore(s); mStatus.restore(s); });
+
+		print(lib::stringf("Recording the last %u instructions, a checkpoint every %llu cycles.",
+			(uint) n, (unsigned long long) Rewind::INTERVAL));
+	}
+	else
+	{
+		throw std::string("HISTORY [OFF|STEPS]");
+	}
+}
+
+void Application::back(const Tokenizer& t)
+{
+	uint n = 1;
+
+	if(t.size() >= 2 && t[1].type == TokenType::NUMBER)
+	{
+		n = t[1].value;
+	}
+
+	if(!mRewind)
+	{
+		throw std::string("No history; turn it on with HISTORY first.");
+	}
+
+	uint i = 0;
+
+	while(i < n && mRewind->back()) ++i;
+
+	print(lib::stringf("Stepped back %u instructions to @$%04X: %s", i, mCPU.getPC(), mCPU.disassemble(mCPU.getPC()).c_str()));
+}
+
+void Application::rewind(const Tokenizer& t)
+{
+	if(t.size() != 2 || t[1].type != TokenType::NUMBER)
+	{
+		throw std::string("REWIND CYCLES");
+	}
+
+	if(!mRewind)
+	{
+		throw std::string("No history; turn it on with HISTORY first.");
+	}
+
+	uint64_t r = mRewind->rewind(t[1].value);
+
+	cpu_running = false;
+
+	print(lib::stringf("Rewound %llu cycles to @$%04X [%uKiB of history left].",
+		(unsigned long long) r, mCPU.getPC(), (uint) (mRewind->getMemory() >> 10)));
+}
+
+void Application::trace(const Tokenizer& t)
+{
+	if(t.size() == 2 && t[1].type == TokenType::LITERAL && t[1].token == "off")
+	{
+		if(mTracer)
+		{
+			mTracer->flush();
+			print(lib::stringf("Traced %llu instructions.", (unsigned long long) mTracer->getRecords()));
+			mTracer.reset();
+		}
+	}
+	else if(t.size() == 2 && t[1].type == TokenType::STRING)
+	{
+		mTracer.reset();
+		mTracer.reset(new Tracer(mCPU, t[1].token));
+
+		print(lib::stringf("Tracing to \"%s\".", t[1].token.c_str()));
+	}
+	else
+	{
+		throw std::string("TRACE OFF|\"FILE.TRC\"");
+	}
+}
+
+void Application::profile(const Tokenizer& t)
+{
+	std::string cmd(t.size() >= 2 && t[1].type == TokenType::LITERAL ? t[1].token : "");
+
+	if(cmd == "start")
+	{
+		mProfiler.reset();
+		mProfiler.reset(new Profiler(mCPU));
+		mProfiler->start();
+
+		print("Profiling.");
+	}
+	else if(cmd == "stop" || cmd == "report")
+	{
+		if(!mProfiler)
+		{
+			throw std::string("No profile; take one with PROFILE START first.");
+		}
+
+		if(cmd == "stop")
+		{
+			mProfiler->stop();
+		}
+
+		uint n = t.size() >= 3 && t[2].type == TokenType::NUMBER ? t[2].value : MXT_PROFILE_LINES;
+		uint64_t total = std::max<uint64_t>(mProfiler->getTotal(), 1);
+		auto v = mProfiler->report(mSymbols);
+
+		print(lib::stringf("%llu cycles in %u %s:", (unsigned long long) mProfiler->getTotal(),
+			(uint) v.size(), mSymbols.empty() ? "addresses" : "routines"));
+
+		for(uint i = 0 ; i < n && i < v.size() ; ++i)
+		{
+			const Profiler::Entry& e(v[i]);
+
+			print(lib::stringf("%5.1f%% %12llu %10llu $%04X %s", 100.0 * e.cycles / total,
+				(unsigned long long) e.cycles, (unsigned long long) e.hits, e.addr, e.name.c_str()));
+		}
+	}
+	else
+	{
+		throw std::string("PROFILE START|STOP|REPORT [N]");
+	}
+}
+
+void Application::speed(const Tokenizer& t)
+{
+	if(t.size() == 1)
+	{
+		print(lib::stringf("Running at %s, effectively %.3f MHz.", mGovernor.toString().c_str(), mGovernor.getMHz()));
+
+		return;
+	}
+
+	if(t[1].type == TokenType::NUMBER && t.size() == 2)
+	{
+		mGovernor.setMultiplied(t[1].value);
+	}
+	else if(t[1].type == TokenType::LITERAL && t[1].token == "turbo" && t.size() == 2)
+	{
+		mGovernor.setTurbo();
+	}
+	else if(t[1].type == TokenType::LITERAL && t[1].token == "exact" && (t.size() == 2 || (t.size() == 3 && t[2].type == TokenType::NUMBER)))
+	{
+		mGovernor.setExact(t.size() == 3 ? t[2].value * 1000ull : Z80::CLOCK);
+	}
+	else
+	{
+		throw std::string("SPEED [EXACT [KHZ]|N|TURBO]");
+	}
+
+	mGovernor.sync(mCPU.getCycles());
+
+	print(lib::stringf("Running at %s.", mGovernor.toString().c_str()));
 }
 
 }
@@ -3,9 +3,12 @@
 
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
 
 #include "z80.h"
 #include "Screen.h"
+#include "Keyboard.h"
 #include "StatusPort.h"
 #include "ScreenWindow.h"
 #include "RAMMonitor.h"
@@ -19,12 +22,26 @@
 #include "Schedule.h"
 #include "Command.h"
 #include "Property.h"
+#include "Rewind.h"
+#include "Tracer.h"
+#include "Profiler.h"
+#include "Symbols.h"
+#include "Governor.h"
+#include "Frames.h"
+#include "Queue.h"
+#include "Thread.h"
 
 namespace z80
 {
+	// The cpu and its devices run on their own thread, so a slow window
+	// can't hold up the guest. Commands from the terminal and the other
+	// windows are queued to it as jobs, and whatever it prints is queued
+	// back to the UI. The windows only ever see the frames it publishes.
 	class Application
 	{
 		typedef void (Application::*command_fn)(const Tokenizer&);
+		typedef std::function<void(void)> job_fn;
+		typedef lib::Queue<job_fn, 1024> queue_t;
 		typedef std::function<std::string(const uint8_t *)> deasm_fn;
 		typedef std::function<void(const Tokenizer::Token&)> set_fn;
 		typedef lib::Property<bool> int_t;
@@ -35,9 +52,17 @@ namespace z80
 			void run( );
 			void execute(const std::string&);
 		private:
-			void tick( );
+			void emulate( );
+			void command(const std::string&);
+			void publish( );
+			void toCPU(job_fn);
+			void toUI(job_fn);
+			void print(const std::string&);
+			void log(const std::string&);
+			uint64_t tick( );
 			void reset( );
 			void toggleBreakpoint(uint16_t);
+			void edit(uint16_t, uint8_t);
 			void createRAMMonitor(uint16_t, uint);
 			void createDisassembler(uint16_t);
 
@@ -51,8 +76,20 @@ namespace z80
 			void set(const Tokenizer&);
 			void interrupt(const Tokenizer&);
 			void setBreak(const Tokenizer&);
+			void watch(const Tokenizer&);
 			void open(const Tokenizer&);
 			void clear(const Tokenizer&);
+			void bench(const Tokenizer&);
+			void dispatch(const Tokenizer&);
+			void lockstep(const Tokenizer&);
+			void save(const Tokenizer&);
+			void restore(const Tokenizer&);
+			void history(const Tokenizer&);
+			void back(const Tokenizer&);
+			void rewind(const Tokenizer&);
+			void trace(const Tokenizer&);
+			void profile(const Tokenizer&);
+			void speed(const Tokenizer&);
 
 		private:
 			template<typename T>
@@ -78,19 +115,28 @@ namespace z80
 			Screen mScreen;
 			Keyboard mKeyboard;
 			StatusPort mStatus;
+			Frames mFrames;
+			Disassembly mDisassembly;
 			ScreenWindow wScreen;
 			StatusWindow wStatus;
 			LogWindow wLog;
 			winui::CommandWindow wTerminal;
-			lib::Schedule mSchedule;
+			lib::Schedule mSchedule, mUI;
+			queue_t mCommands, mOutput;
+			std::unique_ptr<lib::Thread> mThread;
+			std::atomic<bool> mRunning;
 			std::map<std::string, command_fn> mInstructions;
 			std::map<std::string, std::pair<TokenType, set_fn>> mSetFunctions;
 			std::vector<winui::Window *> wWindows;
 
 			bool cpu_running;
 			int_t manualInt;
-			std::vector<uint16_t> breakPoints;
-			uint32_t skipBP_;
+			int_t mVSync;
+			std::unique_ptr<Rewind> mRewind;
+			std::unique_ptr<Tracer> mTracer;
+			std::unique_ptr<Profiler> mProfiler;
+			Symbols mSymbols;
+			Governor mGovernor;
 	};
 }
 
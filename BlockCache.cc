@@ -0,0 +1,151 @@
+#include <algorithm>
+
+#include "BlockCache.h"
+
+namespace z80 {
+
+BlockCache::BlockCache(void)
+	: tracker_(nullptr)
+	, slot_(0)
+	, cur_(nullptr)
+	, ip_(nullptr)
+	, end_(nullptr)
+	, recording_(false)
+	, count_(0)
+{
+}
+
+// Called when the current block does not continue at 'pc'. Keeps recording
+// if possible, otherwise switches to the block starting at 'pc' or opens a
+// new one. Returns nullptr if the instruction has to be decoded and handed
+// to append() first.
+const BlockCache::MicroOp *BlockCache::lookup(uint16_t pc)
+{
+	if(!blocks_)
+	{
+		blocks_.reset(new std::unique_ptr<Block>[0x10000]);
+	}
+
+	if(recording_ && ip_ == end_ && cur_->ops.size() < MAX_OPS && !blocks_[pc])
+	{
+		return nullptr;
+	}
+
+	recording_ = false;
+	ip_ = end_ = nullptr;
+
+	if(!(cur_ = blocks_[pc].get()))
+	{
+		blocks_[pc].reset(cur_ = new Block);
+		recording_ = true;
+		++count_;
+
+		return nullptr;
+	}
+
+	ip_ = cur_->ops.data();
+	end_ = ip_ + cur_->ops.size();
+
+	return ip_++;
+}
+
+const BlockCache::MicroOp *BlockCache::append(const MicroOp& op, WriteTracker& t)
+{
+	if(!tracker_)
+	{
+		tracker_ = &t;
+		slot_ = t.subscribe([this](uint16_t a) { return invalidate(a); });
+	}
+
+	uint16_t start = cur_->ops.empty() ? op.pc : cur_->ops.front().pc;
+
+	cur_->ops.push_back(op);
+
+	for(uint i = 0 ; i < op.len ; ++i)
+	{
+		uint8_t p = (uint16_t)(op.pc + i) >> 8;
+
+		if(std::find(cur_->pages.begin(), cur_->pages.end(), p) == cur_->pages.end())
+		{
+			cur_->pages.push_back(p);
+			owners_[p].push_back(start);
+			tracker_->mark(slot_, p);
+		}
+	}
+
+	ip_ = end_ = cur_->ops.data() + cur_->ops.size();
+
+	return &cur_->ops.back();
+}
+
+// Drops every block with an opcode byte at 'a'. Returns whether blocks
+// remain on the page.
+bool BlockCache::invalidate(uint16_t a)
+{
+	std::vector<uint16_t> hit;
+
+	for(const auto& start : owners_[a >> 8])
+	{
+		for(const auto& op : blocks_[start]->ops)
+		{
+			if((uint16_t)(a - op.pc) < op.len)
+			{
+				hit.push_back(start);
+				break;
+			}
+		}
+	}
+
+	for(const auto& start : hit)
+	{
+		drop(start);
+	}
+
+	return !owners_[a >> 8].empty();
+}
+
+void BlockCache::drop(uint16_t start)
+{
+	Block *b = blocks_[start].get();
+
+	for(const auto& p : b->pages)
+	{
+		auto& o(owners_[p]);
+
+		o.erase(std::find(o.begin(), o.end(), start));
+
+		if(o.empty())
+		{
+			tracker_->unmark(slot_, p);
+		}
+	}
+
+	if(cur_ == b)
+	{
+		leave();
+	}
+
+	blocks_[start].reset();
+	--count_;
+}
+
+void BlockCache::clear(void)
+{
+	blocks_.reset();
+
+	for(uint i = 0 ; i < 0x100 ; ++i)
+	{
+		owners_[i].clear();
+
+		if(tracker_)
+		{
+			tracker_->unmark(slot_, i);
+		}
+	}
+
+	leave();
+	count_ = 0;
+}
+
+}
+
@@ -0,0 +1,94 @@
+#ifndef Z80_BLOCKCACHE_H
+#define Z80_BLOCKCACHE_H
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+#include "WriteTracker.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	class Z80;
+
+	// Decoded blocks of guest code, keyed by the address of their first
+	// instruction. A block is recorded while it executes for the first time
+	// and replayed afterwards; every micro-op remembers its own address, so
+	// a branch that goes the other way simply leaves the block.
+	// Only opcode and prefix bytes (and the DDCB/FDCB displacement) are
+	// pre-decoded. Immediate operands are still fetched by the handlers,
+	// so writes only have to invalidate blocks covering opcode bytes; the
+	// cache subscribes to the cpu's WriteTracker for the pages it uses.
+	class BlockCache
+	{
+		public:
+			typedef void (*op_fn)(Z80&, uint8_t, uint8_t);
+			typedef uint (*native_fn)(Z80 *);
+
+			struct MicroOp
+			{
+				op_fn fn;
+				uint16_t pc;
+				uint8_t ins, t8;
+				uint8_t table;  // opcode table the handler came from
+				uint8_t len;    // opcode bytes, prefixes included
+				uint8_t cycles;
+			};
+
+			// 'native' covers the first 'nativeOps' micro-ops once the
+			// block has been compiled; 'worst' bounds their T-states.
+			struct Block
+			{
+				std::vector<MicroOp> ops;
+				std::vector<uint8_t> pages;
+				uint hits;
+				bool compiled;
+				native_fn native;
+				uint nativeOps;
+				uint worst;
+
+				Block( ) : hits(0), compiled(false), native(nullptr), nativeOps(0), worst(0) { }
+			};
+
+			static const uint MAX_OPS = 32;
+
+		public:
+			BlockCache( );
+			BlockCache(const BlockCache&) : BlockCache( ) { }
+			BlockCache& operator=(const BlockCache&) { clear(); tracker_ = nullptr; return *this; }
+			const MicroOp *next(uint16_t pc)
+			{
+				if(ip_ != end_ && ip_->pc == pc)
+				{
+					return ip_++;
+				}
+
+				return lookup(pc);
+			}
+			const MicroOp *append(const MicroOp&, WriteTracker&);
+			Block *find(uint16_t pc) const { return blocks_ ? blocks_[pc].get() : nullptr; }
+			bool isRecording(const Block *b) const { return recording_ && cur_ == b; }
+			void leave( ) { cur_ = nullptr; ip_ = end_ = nullptr; recording_ = false; }
+			bool invalidate(uint16_t);
+			void clear( );
+			uint size( ) const { return count_; }
+		private:
+			const MicroOp *lookup(uint16_t);
+			void drop(uint16_t);
+
+		private:
+			std::unique_ptr<std::unique_ptr<Block>[]> blocks_;
+			std::vector<uint16_t> owners_[0x100];
+			WriteTracker *tracker_;
+			uint slot_;
+			Block *cur_;
+			const MicroOp *ip_, *end_;
+			bool recording_;
+			uint count_;
+	};
+}
+
+#endif
+
@@ -0,0 +1,108 @@
+#include "Breakpoints.h"
+
+namespace z80 {
+
+void Breakpoints::set(uint16_t a)
+{
+	conds_.erase(a);
+
+	if(bits_.empty())
+	{
+		bits_.resize(0x10000 / 64);
+	}
+
+	if(!test(a))
+	{
+		bits_[a >> 6] |= 1ull << (a & 63);
+		++count_;
+	}
+}
+
+void Breakpoints::set(uint16_t a, const Condition& c)
+{
+	set(a);
+	conds_[a] = c;
+}
+
+const Breakpoints::Condition *Breakpoints::getCondition(uint16_t a) const
+{
+	auto i = conds_.find(a);
+
+	return i == conds_.end() ? nullptr : &i->second;
+}
+
+// Called once the cpu arrived at a breakpoint; returns whether it stops.
+bool Breakpoints::check(const Z80& cpu, uint16_t a)
+{
+	auto i = conds_.find(a);
+
+	if(i == conds_.end())
+	{
+		return true;
+	}
+
+	Condition& c(i->second);
+
+	if(!c.expr.eval(cpu, a))
+	{
+		return false;
+	}
+
+	return ++c.hits >= c.count;
+}
+
+void Breakpoints::unset(uint16_t a)
+{
+	conds_.erase(a);
+
+	if(test(a))
+	{
+		bits_[a >> 6] &= ~(1ull << (a & 63));
+		--count_;
+	}
+}
+
+// Returns whether there is a breakpoint at 'a' now.
+bool Breakpoints::toggle(uint16_t a)
+{
+	if(test(a))
+	{
+		unset(a);
+
+		return false;
+	}
+	else
+	{
+		set(a);
+
+		return true;
+	}
+}
+
+void Breakpoints::clear(void)
+{
+	bits_.clear();
+	conds_.clear();
+	count_ = 0;
+}
+
+std::vector<uint16_t> Breakpoints::list(void) const
+{
+	std::vector<uint16_t> r;
+
+	for(uint i = 0 ; count_ && i < bits_.size() ; ++i)
+	{
+		for(uint j = 0 ; j < 64 && (bits_[i] >> j) ; ++j)
+		{
+			if((bits_[i] >> j) & 1)
+			{
+				r.push_back(i * 64 + j);
+			}
+		}
+	}
+
+	return r;
+}
+
+}
+
@@ -0,0 +1,52 @@
+#ifndef Z80_BREAKPOINTS_H
+#define Z80_BREAKPOINTS_H
+
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include "Expression.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Execution breakpoints, one bit per address. The bitmap is only
+	// allocated once the first breakpoint is set, and the cpu only looks
+	// at it while there is at least one, so a run without breakpoints
+	// pays nothing per instruction.
+	// Conditions and hit counts live next to the bitmap and only get
+	// looked at once the cpu arrives at their address.
+	class Breakpoints
+	{
+		public:
+			// A hit only counts while the condition holds, and the cpu
+			// stops from the 'count'th hit on.
+			struct Condition
+			{
+				Expression expr;
+				uint count, hits;
+			};
+
+		public:
+			Breakpoints( ) : count_(0) { }
+			bool any( ) const { return count_; }
+			uint size( ) const { return count_; }
+			bool test(uint16_t a) const { return count_ && ((bits_[a >> 6] >> (a & 63)) & 1); }
+			void set(uint16_t);
+			void set(uint16_t, const Condition&);
+			const Condition *getCondition(uint16_t) const;
+			bool check(const Z80&, uint16_t);
+			void unset(uint16_t);
+			bool toggle(uint16_t);
+			void clear( );
+			std::vector<uint16_t> list( ) const;
+		private:
+			std::vector<uint64_t> bits_;
+			std::map<uint16_t, Condition> conds_;
+			uint count_;
+	};
+}
+
+#endif
+
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <iterator>
+
 #include "Command.h"
 
 namespace z80
@@ -72,13 +75,37 @@ namespace z80
 				{
 					type = TokenType::STRING;
 				}
+				else if(isOperator(c))
+				{
+					type = TokenType::OPERATOR;
+					token.push_back(c);
+				}
+				break;
+			case TokenType::OPERATOR:
+				{
+					static const char * const pairs[] = { "==", "!=", "<=", ">=", "&&", "||", "<<", ">>" };
+
+					std::string op(token + c);
+
+					type = TokenType::UNKNOWN;
+
+					if(std::find(std::begin(pairs), std::end(pairs), op) != std::end(pairs))
+					{
+						push(TokenType::OPERATOR, op, 0);
+					}
+					else
+					{
+						push(TokenType::OPERATOR, token, 0);
+						process(c);
+					}
+				}
 				break;
 			case TokenType::LITERAL:
 				if(c >= 'A' && c <= 'Z')
 				{
 					process(c - 'A' + 'a');
 				}
-				else if((c >= 'a' && c <= 'z') || c == '_' || c == '-')
+				else if((c >= 'a' && c <= 'z') || c == '_')
 				{
 					token.push_back(c);
 				}
@@ -157,7 +184,10 @@ namespace z80
 						process(c);
 						break;
 					default:
-						throw std::string("Malformed numerical constant.");
+						push(TokenType::NUMBER, token, value);
+						type = TokenType::UNKNOWN;
+						process(c);
+						break;
 				}
 				else if(checkNum == 2 || isInt(c, base))
 				{
@@ -216,6 +246,13 @@ namespace z80
 		return v;
 	}
 
+	bool Tokenizer::isOperator(char c)
+	{
+		static const std::string ops("=!<>&|^~+-*/%()");
+
+		return ops.find(c) != std::string::npos;
+	}
+
 	bool Tokenizer::isInt(char c, uint b)
 	{
 		uint v = 0;
@@ -253,6 +290,7 @@ namespace z80
 			case TokenType::LITERAL: return "Literal";
 			case TokenType::NUMBER: return "Number";
 			case TokenType::STRING: return "String";
+			case TokenType::OPERATOR: return "Operator";
 		}
 
 		throw std::string("Invalid tokentype!");
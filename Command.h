@@ -13,7 +13,8 @@ namespace z80
 		UNKNOWN,
 		LITERAL,
 		STRING,
-		NUMBER
+		NUMBER,
+		OPERATOR
 	};
 
 	class Tokenizer
@@ -41,6 +42,7 @@ namespace z80
 			void push(TokenType, const std::string&, uint);
 			static uint toInt(char, uint);
 			static bool isInt(char, uint);
+			static bool isOperator(char);
 
 		private:
 			vec_t buf_;
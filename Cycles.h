@@ -0,0 +1,30 @@
+#ifndef Z80_CYCLES_H
+#define Z80_CYCLES_H
+
+#include <stdint.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// T-state timings of the Z80 instruction set.
+	// Prefixed tables hold the complete instruction time, so the unprefixed
+	// table lists 0 for the prefix bytes themselves.
+	struct Cycles
+	{
+		static const uint8_t MAIN[0x100];
+		static const uint8_t CB[0x100];
+		static const uint8_t ED[0x100];
+		static const uint8_t XY[0x100];
+		static const uint8_t XYCB[0x100];
+
+		static const uint JR_TAKEN = 5;   // jr cc / djnz: 7 (8) -> 12 (13)
+		static const uint RET_TAKEN = 6;  // ret cc: 5 -> 11
+		static const uint CALL_TAKEN = 7; // call cc: 10 -> 17
+		static const uint BLOCK_REPEAT = 5; // ldir & co: 16 -> 21
+		static const uint IRQ = 13;       // interrupt acknowledge in mode 1
+	};
+}
+
+#endif
+
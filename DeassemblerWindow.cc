@@ -1,7 +1,11 @@
+#include <algorithm>
+
 #include "DeassemblerWindow.h"
 
 #define MXT_HEADER " ADDR |             Instruction"
 #define MXT_VLINE 6
+#define MXT_PREFIX 8
+#define MXT_BYTES 12
 
 #define WIN_TITLE "Z80 Disassembler"
 #define WIN_W (5+3+(4*2+3)+1+24)
@@ -13,6 +17,7 @@
 #define CHAR_COLORSPACE 8
 
 #define MXT_ERROR "ERR"
+#define MXT_HEAT " .:-=+*#@"
 
 namespace z80 {
 
@@ -24,13 +29,14 @@ using winui::Color;
 using winui::CharacterWindow;
 using lib::Character;
 
-DeassemblerWindow::DeassemblerWindow(Z80& cpu, uint lc)
+DeassemblerWindow::DeassemblerWindow(Frames& frames, Disassembly& disasm, uint lc)
 	: CharacterWindow(WIN_TITLE, Position::CENTER(), Dimension(WIN_W, WIN_H + lc), Image(CHARSET_PATH), Dimension(CHAR_W, CHAR_H), CHAR_COLORSPACE)
 	, cLines_(lc)
-	, cpu_(&cpu)
+	, frames_(&frames)
+	, disasm_(&disasm)
 {
 	pc_ = sel_ = addr_ = 0;
-	followPC_ = false;
+	followPC_ = jump_ = false;
 	off_ = 0;
 
 	state_ = State::DEFAULT;
@@ -68,10 +74,12 @@ void DeassemblerWindow::onUpdate(uint ms)
 
 void DeassemblerWindow::onRender(void)
 {
-	if(followPC_ && pc_ != cpu_->getPC())
+	// a step back shows up with the next frame
+	if((followPC_ || jump_) && pc_ != cpu().getPC())
 	{
-		pc_ = addr_ = cpu_->getPC();
+		pc_ = addr_ = cpu().getPC();
 		off_ = 0;
+		jump_ = false;
 	}
 
 	uint a = addr_;
@@ -107,9 +115,9 @@ void DeassemblerWindow::onRender(void)
 		}
 		else
 		{
-			Instruction de = disassemble(&cpu_->RAM(a));
-			if(i >= off_) renderLine(i - off_ + 2, a, de);
-			a += de.size;
+			const Disassembly::Line& l(disasm_->get(cpu(), a));
+			if(i >= off_) renderLine(i - off_ + 2, a, l);
+			a += l.ins.size;
 		}
 	}
 
@@ -209,7 +217,7 @@ void DeassemblerWindow::onEventDefault(const SDL_Event& e)
 				case SDLK_f:
 					if((followPC_ = !followPC_))
 					{
-						pc_ = addr_ = cpu_->getPC();
+						pc_ = addr_ = cpu().getPC();
 					}
 					break;
 				case SDLK_g:
@@ -217,6 +225,12 @@ void DeassemblerWindow::onEventDefault(const SDL_Event& e)
 					setGotoCursor();
 					clearBuf();
 					break;
+				case SDLK_b:
+					if(stepBack_ && stepBack_())
+					{
+						jump_ = true;
+					}
+					break;
 			}
 	}
 
@@ -256,27 +270,38 @@ std::string DeassemblerWindow::getFooder(void)
 	return "";
 }
 
-void DeassemblerWindow::renderLine(uint y, uint16_t addr, const Instruction& ins)
+// The mnemonic comes preformatted from the cache, the address, bytes and
+// markers get filled in without any formatting of strings.
+void DeassemblerWindow::renderLine(uint y, uint16_t addr, const Disassembly::Line& l)
 {
-	bool isPC = pc_ >= addr && pc_ < addr + ins.size;
+	bool isPC = pc_ >= addr && pc_ < addr + l.ins.size;
 	bool isSel = sel_ == y;
 	uint c = isPC ? COLOR_RED : isSel ? COLOR_CYAN : COLOR_BLACK;
 
 	addresses_[y] = addr;
 
-	std::string raw;
+	static const std::string heat(MXT_HEAT);
+	static const char * const hex = "0123456789ABCDEF";
+	uint h = heat_ ? std::min<uint>(heat_(addr), heat.size() - 1) : 0;
+	char s[WIN_W + 1] = {
+		'$', hex[addr >> 12], hex[(addr >> 8) & 0xF], hex[(addr >> 4) & 0xF], hex[addr & 0xF],
+		checkBreak_(addr) ? '*' : ' ', '|', heat.at(h) };
+	uint n = MXT_PREFIX;
 
-	for(uint i = 0 ; i < ins.size ; ++i)
+	for(uint i = 0 ; i < l.ins.size && i < Decoded::MAX_SIZE ; ++i)
 	{
-		raw += lib::stringf("%02X ", cpu_->RAM(addr + i));
+		s[n++] = hex[l.ins.bytes[i] >> 4];
+		s[n++] = hex[l.ins.bytes[i] & 0xF];
+		s[n++] = ' ';
 	}
 
-	std::string s(lib::stringf(
-		"$%04X%c| %- 12s %s", addr, checkBreak_(addr) ? '*' : ' ', raw.c_str(), ins.literal.c_str()));
+	while(n < MXT_PREFIX + MXT_BYTES + 1) s[n++] = ' ';
+
+	for(const char *p = l.text ; *p && n < WIN_W ; ++p) s[n++] = *p;
 
 	for(uint x = 0 ; x < WIN_W ; ++x)
 	{
-		renderChar(Position(x, y), x == MXT_VLINE ? Character::S_UD : (x >= s.size() ? ' ' : s.at(x)), c, isPC || isSel);
+		renderChar(Position(x, y), x == MXT_VLINE ? Character::S_UD : (x < n ? s[x] : ' '), c, isPC || isSel);
 	}
 }
 
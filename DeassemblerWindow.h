@@ -6,10 +6,10 @@
 #include <map>
 
 #include "lib.h"
-#include "Z80.h"
+#include "Frames.h"
 #include "CharacterWindow.h"
 #include "Image.h"
-#include "Disassemble.h"
+#include "Disassembly.h"
 
 #define MXT_LINECOUNT 59
 
@@ -21,6 +21,8 @@ namespace z80
 		typedef std::function<bool(uint16_t)> check_break_fn;
 		typedef std::function<void(uint16_t)> set_break_fn;
 		typedef std::pair<check_break_fn, set_break_fn> break_t;
+		typedef std::function<bool(void)> step_back_fn;
+		typedef std::function<uint(uint16_t)> heat_fn;
 
 		static const uint COLOR_BLACK   = 0x00; // ---
 		static const uint COLOR_BLUE    = 0x01; // --B
@@ -38,20 +40,23 @@ namespace z80
 		};
 
 		public:
-			DeassemblerWindow(Z80&, uint = MXT_LINECOUNT);
+			DeassemblerWindow(Frames&, Disassembly&, uint = MXT_LINECOUNT);
 			virtual ~DeassemblerWindow( );
 			void setAddress(uint16_t a) { addr_ = a; }
 			void setLabelMap(const map_t& m) { map_ = m; }
 			void setFollowPC(bool v) { followPC_ = v; }
 			void setBreakPointCallback(break_t p) { checkBreak_ = p.first; setBreak_ = p.second; }
+			void setStepBackCallback(step_back_fn f) { stepBack_ = f; }
+			void setHeatCallback(heat_fn f) { heat_ = f; }
 		private:
+			const Z80& cpu( ) { return frames_->front().cpu; }
 			void onUpdate(uint);
 			void onRender( );
 			void onEvent(const SDL_Event&);
 			void onEventDefault(const SDL_Event&);
 			void onEventGoto(const SDL_Event&);
 			std::string getFooder( );
-			void renderLine(uint, uint16_t, const Instruction&);
+			void renderLine(uint, uint16_t, const Disassembly::Line&);
 			void renderEmptyLine(uint);
 			void scroll(int);
 			void click(int, bool);
@@ -63,10 +68,13 @@ namespace z80
 			map_t map_;
 			uint cLines_, off_;
 			uint16_t pc_, addr_, sel_;
-			Z80 *cpu_;
-			bool followPC_, scrollable_;
+			Frames *frames_;
+			Disassembly *disasm_;
+			bool followPC_, scrollable_, jump_;
 			check_break_fn checkBreak_;
 			set_break_fn setBreak_;
+			step_back_fn stepBack_;
+			heat_fn heat_;
 			std::map<uint, uint16_t> addresses_;
 			uint8_t aBuf_[4];
 			int aBufPos_;
@@ -2,17 +2,85 @@
 #define Z80_DISASSEMBLE_H
 
 #include <string>
+#include <stdint.h>
 
 #include "lib.h"
 
+typedef unsigned uint;
+
 namespace z80
 {
+	enum class Mnemonic : uint8_t
+	{
+		INVALID,
+		NOP, LD, INC, DEC, EX, EXX, ADD, ADC, SUB, SBC, AND, XOR, OR, CP,
+		RLCA, RRCA, RLA, RRA, DAA, CPL, SCF, CCF, HALT, DI, EI,
+		DJNZ, JR, JP, CALL, RET, RETI, RETN, RST, PUSH, POP,
+		IN, OUT, NEG, IM, RRD, RLD,
+		LDI, CPI, INI, OUTI, LDD, CPD, IND, OUTD,
+		LDIR, CPIR, INIR, OTIR, LDDR, CPDR, INDR, OTDR,
+		RLC, RRC, RL, RR, SLA, SRA, SLL, SRL, BIT, RES, SET,
+		COUNT
+	};
+
+	enum class Register : uint8_t
+	{
+		B, C, D, E, H, L, A, I, R, IXH, IXL, IYH, IYL,
+		BC, DE, HL, SP, AF, AF_ALT, IX, IY,
+		COUNT
+	};
+
+	enum class OperandType : uint8_t
+	{
+		NONE,
+		REG,   // b, hl, af', ...
+		IMM8,  // 0x12
+		IMM16, // $1234
+		ADDR,  // ($1234)
+		PORT,  // (0x12)
+		IND,   // (hl), (sp), (c), ...
+		INDEX, // (ix+d); the value holds d
+		REL,   // the offset of a relative jump
+		COND,  // nz, z, nc, c, po, pe, p, m
+		RST,   // the target of a rst
+		NUM    // bit numbers, interrupt modes, ...
+	};
+
+	struct Operand
+	{
+		OperandType type;
+		Register reg;
+		uint16_t value;
+	};
+
+	// One decoded instruction, as plain data. 'cycles' is its time in
+	// T-states, 'taken' that of a branch that's taken (or a block
+	// instruction that repeats), which for any other instruction is the
+	// same.
+	struct Decoded
+	{
+		static const uint MAX_SIZE = 4;
+		static const uint MAX_OPERANDS = 3;
+		static const uint MAX_TEXT = 24;
+
+		Mnemonic mnemonic;
+		uint8_t size;
+		uint8_t cycles, taken;
+		uint8_t count;
+		Operand operands[MAX_OPERANDS];
+		uint8_t bytes[MAX_SIZE];
+	};
+
 	struct Instruction
 	{
 		std::string literal;
 		uint size;
 	};
 
+	bool decode(const uint8_t *, uint, Decoded&);
+	uint format(const Decoded&, char *, uint);
+	const char *getName(Mnemonic);
+	const char *getName(Register);
 	Instruction disassemble(const uint8_t *);
 }
 
@@ -0,0 +1,73 @@
+#include "Disassembly.h"
+#include "Z80.h"
+
+namespace z80 {
+
+Disassembly::Disassembly(void)
+{
+	for(Page& p : pages_)
+	{
+		p.gen = p.next = 0;
+	}
+}
+
+const Disassembly::Line& Disassembly::get(const Z80& cpu, uint16_t a)
+{
+	uint p = a >> Memory::PAGE_SHIFT;
+	uint64_t gen = cpu.getMemory().getGeneration(p);
+	uint64_t next = cpu.getMemory().getGeneration((p + 1) % Memory::PAGES);
+	Page& page(pages_[p]);
+
+	if(!gen || !next)
+	{
+		decode(cpu, a, scratch_);
+
+		return scratch_;
+	}
+
+	if(page.lines.empty())
+	{
+		page.lines.resize(Memory::PAGE_SIZE);
+	}
+
+	// only the last few instructions of a page can reach into the next one
+	if(page.gen != gen || page.next != next)
+	{
+		auto i = page.gen != gen ? page.lines.begin() : page.lines.end() - 3;
+
+		for(; i != page.lines.end() ; ++i)
+		{
+			i->valid = false;
+		}
+
+		page.gen = gen;
+		page.next = next;
+	}
+
+	Line& l(page.lines[a & (Memory::PAGE_SIZE - 1)]);
+
+	if(!l.valid)
+	{
+		decode(cpu, a, l);
+	}
+
+	return l;
+}
+
+void Disassembly::decode(const Z80& cpu, uint16_t a, Line& l)
+{
+	uint8_t buf[Decoded::MAX_SIZE];
+
+	// the address space wraps around at $FFFF
+	for(uint i = 0 ; i < Decoded::MAX_SIZE ; ++i)
+	{
+		buf[i] = cpu.peek(a + i);
+	}
+
+	z80::decode(buf, sizeof(buf), l.ins);
+	format(l.ins, l.text, sizeof(l.text));
+	l.valid = true;
+}
+
+}
+
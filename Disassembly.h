@@ -0,0 +1,50 @@
+#ifndef Z80_DISASSEMBLY_H
+#define Z80_DISASSEMBLY_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "Disassemble.h"
+#include "Memory.h"
+
+namespace z80
+{
+	class Z80;
+
+	// Decoded and formatted instructions by address, kept across frames
+	// for the windows that show disassembly. A 4 KiB page of entries
+	// stays valid for as long as the generation of its memory doesn't
+	// change (the last few entries, which can reach into the next page,
+	// also depend on that one's), so only code that has been written to
+	// since the last frame gets decoded and formatted again. Pages that
+	// aren't RAM are decoded afresh every time.
+	class Disassembly
+	{
+		public:
+			struct Line
+			{
+				Decoded ins;
+				char text[Decoded::MAX_TEXT];
+				bool valid;
+			};
+
+		public:
+			Disassembly( );
+			const Line& get(const Z80&, uint16_t);
+		private:
+			void decode(const Z80&, uint16_t, Line&);
+
+		private:
+			struct Page
+			{
+				uint64_t gen, next;
+				std::vector<Line> lines;
+			};
+
+			Page pages_[Memory::PAGES];
+			Line scratch_;
+	};
+}
+
+#endif
+
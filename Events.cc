@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <string>
+
+#include "Events.h"
+
+namespace z80 {
+
+namespace
+{
+	struct Later
+	{
+		template<typename T>
+		bool operator()(const T& e1, const T& e2) const { return e1.when > e2.when; }
+	};
+}
+
+// Fires 'f' every 'period' T-states, the first time at the multiple of
+// the period following 'now'. Returns a handle to cancel it with.
+uint Events::schedule(event_fn f, uint64_t period, uint64_t now)
+{
+	if(!period)
+	{
+		throw std::string("Invalid event period!");
+	}
+
+	heap_.push_back(Event { (now / period + 1) * period, period, ++id_, f });
+	std::push_heap(heap_.begin(), heap_.end(), Later());
+	update();
+
+	return id_;
+}
+
+void Events::cancel(uint id)
+{
+	heap_.erase(std::remove_if(heap_.begin(), heap_.end(), [id](const Event& e) { return e.id == id; }), heap_.end());
+	std::make_heap(heap_.begin(), heap_.end(), Later());
+	update();
+}
+
+void Events::clear(void)
+{
+	heap_.clear();
+	update();
+}
+
+// Moves every deadline to the multiple of its period following 'now',
+// for when the clock jumped (a restored snapshot, a rewind).
+void Events::align(uint64_t now)
+{
+	for(Event& e : heap_)
+	{
+		e.when = (now / e.period + 1) * e.period;
+	}
+
+	std::make_heap(heap_.begin(), heap_.end(), Later());
+	update();
+}
+
+// Events fire in order of their deadlines; a handler may schedule or
+// cancel others.
+void Events::run(uint64_t now)
+{
+	while(next_ <= now)
+	{
+		std::pop_heap(heap_.begin(), heap_.end(), Later());
+
+		Event& e(heap_.back());
+		event_fn f(e.f);
+
+		e.when += e.period;
+		std::push_heap(heap_.begin(), heap_.end(), Later());
+		update();
+
+		f();
+	}
+}
+
+void Events::update(void)
+{
+	next_ = heap_.empty() ? NEVER : heap_.front().when;
+}
+
+}
+
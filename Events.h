@@ -0,0 +1,53 @@
+#ifndef Z80_EVENTS_H
+#define Z80_EVENTS_H
+
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Periodic events of the devices on a board, timed in T-states of its
+	// cpu. The cpu runs up to the earliest deadline in one go and fires
+	// the events that are due, so what the guest sees no longer depends
+	// on the host at all. Deadlines fall on multiples of their period,
+	// which keeps them in phase across snapshots and forks.
+	// Copies start out empty; the callbacks belong to the original board.
+	class Events
+	{
+		public:
+			typedef std::function<void(void)> event_fn;
+
+			static const uint64_t NEVER = (uint64_t) -1;
+
+		public:
+			Events( ) : next_(NEVER) { }
+			Events(const Events&) : next_(NEVER) { }
+			Events& operator=(const Events&) { return *this; }
+			uint schedule(event_fn, uint64_t, uint64_t);
+			void cancel(uint);
+			void clear( );
+			void align(uint64_t);
+			uint64_t next( ) const { return next_; }
+			void run(uint64_t);
+		private:
+			struct Event
+			{
+				uint64_t when, period;
+				uint id;
+				event_fn f;
+			};
+
+			void update( );
+
+		private:
+			std::vector<Event> heap_;
+			uint64_t next_;
+			uint id_ = 0;
+	};
+}
+
+#endif
+
@@ -0,0 +1,329 @@
+#include <string>
+
+#include "Expression.h"
+#include "Z80.h"
+#include "lib.h"
+
+namespace z80 {
+
+namespace
+{
+	typedef Expression::Op Op;
+
+	enum Register
+	{
+		REG_A, REG_F, REG_B, REG_C, REG_D, REG_E, REG_H, REG_L,
+		REG_AF, REG_BC, REG_DE, REG_HL, REG_IX, REG_IY, REG_SP, REG_PC,
+		REG_I, REG_R,
+		REG_COUNT
+	};
+
+	const char * const registers[REG_COUNT] =
+	{
+		"a", "f", "b", "c", "d", "e", "h", "l",
+		"af", "bc", "de", "hl", "ix", "iy", "sp", "pc",
+		"i", "r"
+	};
+
+	const struct { const char *name; uint8_t mask; } flags[] =
+	{
+		{ "sf", Z80::FLAG_S },
+		{ "zf", Z80::FLAG_Z },
+		{ "hf", Z80::FLAG_H },
+		{ "pf", Z80::FLAG_PV },
+		{ "nf", Z80::FLAG_N },
+		{ "cf", Z80::FLAG_C }
+	};
+
+	// Binary operators by precedence, loosest first.
+	const struct { const char *token; Op op; } binary[][4] =
+	{
+		{ { "||", Op::LOR } },
+		{ { "&&", Op::LAND } },
+		{ { "|", Op::OR } },
+		{ { "^", Op::XOR } },
+		{ { "&", Op::AND } },
+		{ { "==", Op::EQ }, { "!=", Op::NE } },
+		{ { "<", Op::LT }, { "<=", Op::LE }, { ">", Op::GT }, { ">=", Op::GE } },
+		{ { "<<", Op::SHL }, { ">>", Op::SHR } },
+		{ { "+", Op::ADD }, { "-", Op::SUB } },
+		{ { "*", Op::MUL }, { "/", Op::DIV }, { "%", Op::MOD } }
+	};
+
+	const uint LEVELS = sizeof(binary) / sizeof(binary[0]);
+
+	// Recursive descent, emitting the code in postfix order.
+	class Parser
+	{
+		public:
+			Parser(const Tokenizer& t, size_t i, std::vector<Expression::Code>& code)
+				: t_(t), i_(i), depth_(0), code_(code) { }
+			void parse( )
+			{
+				if(i_ >= t_.size())
+				{
+					throw std::string("Empty condition!");
+				}
+
+				parseBinary(0);
+
+				if(i_ < t_.size())
+				{
+					throw std::string("Unexpected '" + t_[i_].token + "' in condition!");
+				}
+			}
+		private:
+			bool isOperator(const char *op) const
+			{
+				return i_ < t_.size() && t_[i_].type == TokenType::OPERATOR && t_[i_].token == op;
+			}
+			void expect(const char *op)
+			{
+				if(!isOperator(op))
+				{
+					throw lib::stringf("Expected '%s' in condition!", op);
+				}
+
+				++i_;
+			}
+			void emit(Op op, uint32_t arg, int d)
+			{
+				if((depth_ += d) > (int) Expression::MAX_DEPTH)
+				{
+					throw std::string("Condition is too complex!");
+				}
+
+				code_.push_back(Expression::Code { op, arg });
+			}
+			void parseBinary(uint level)
+			{
+				if(level == LEVELS)
+				{
+					parseUnary();
+
+					return;
+				}
+
+				parseBinary(level + 1);
+
+				for(bool found = true ; found ; )
+				{
+					found = false;
+
+					for(const auto& b : binary[level])
+					{
+						if(b.token && isOperator(b.token))
+						{
+							++i_;
+							parseBinary(level + 1);
+							emit(b.op, 0, -1);
+							found = true;
+
+							break;
+						}
+					}
+				}
+			}
+			void parseUnary( )
+			{
+				static const struct { const char *token; Op op; } unary[] = { { "-", Op::NEG }, { "!", Op::NOT }, { "~", Op::INV } };
+
+				for(const auto& u : unary)
+				{
+					if(isOperator(u.token))
+					{
+						++i_;
+						parseUnary();
+						emit(u.op, 0, 0);
+
+						return;
+					}
+				}
+
+				parsePrimary();
+			}
+			void parsePrimary( )
+			{
+				if(i_ >= t_.size())
+				{
+					throw std::string("Condition ends prematurely!");
+				}
+
+				const Tokenizer::Token& tk(t_[i_++]);
+
+				if(tk.type == TokenType::NUMBER)
+				{
+					emit(Op::NUM, tk.value, 1);
+				}
+				else if(tk.type == TokenType::OPERATOR && tk.token == "(")
+				{
+					parseBinary(0);
+					expect(")");
+				}
+				else if(tk.type == TokenType::LITERAL)
+				{
+					parseName(tk.token);
+				}
+				else
+				{
+					throw std::string("Unexpected '" + tk.token + "' in condition!");
+				}
+			}
+			void parseName(const std::string& name)
+			{
+				if(name == "mem" || name == "word")
+				{
+					expect("(");
+					parseBinary(0);
+					expect(")");
+					emit(name == "mem" ? Op::MEM : Op::WORD, 0, 0);
+
+					return;
+				}
+
+				if(name == "addr" || name == "value")
+				{
+					emit(name == "addr" ? Op::ADDR : Op::VALUE, 0, 1);
+
+					return;
+				}
+
+				for(uint r = 0 ; r < REG_COUNT ; ++r)
+				{
+					if(name == registers[r])
+					{
+						emit(Op::REG, r, 1);
+
+						return;
+					}
+				}
+
+				for(const auto& f : flags)
+				{
+					if(name == f.name)
+					{
+						emit(Op::FLAG, f.mask, 1);
+
+						return;
+					}
+				}
+
+				throw std::string("Unknown name '" + name + "' in condition!");
+			}
+
+		private:
+			const Tokenizer& t_;
+			size_t i_;
+			int depth_;
+			std::vector<Expression::Code>& code_;
+	};
+
+	uint32_t reg(const Z80::Registers& r, uint i)
+	{
+		switch(i)
+		{
+			case REG_A:  return r.AF >> 8;
+			case REG_F:  return r.AF & 0xFF;
+			case REG_B:  return r.BC >> 8;
+			case REG_C:  return r.BC & 0xFF;
+			case REG_D:  return r.DE >> 8;
+			case REG_E:  return r.DE & 0xFF;
+			case REG_H:  return r.HL >> 8;
+			case REG_L:  return r.HL & 0xFF;
+			case REG_AF: return r.AF;
+			case REG_BC: return r.BC;
+			case REG_DE: return r.DE;
+			case REG_HL: return r.HL;
+			case REG_IX: return r.IX;
+			case REG_IY: return r.IY;
+			case REG_SP: return r.SP;
+			case REG_PC: return r.PC;
+			case REG_I:  return r.IR >> 8;
+			case REG_R:  return r.IR & 0xFF;
+		}
+
+		return 0;
+	}
+}
+
+// Compiles the tokens of 't' from the 'i'th one on.
+Expression::Expression(const Tokenizer& t, size_t i)
+{
+	Parser(t, i, code_).parse();
+
+	for(size_t j = i ; j < t.size() ; ++j)
+	{
+		if(j > i) src_ += " ";
+		src_ += t[j].token;
+	}
+}
+
+// 'a' and 'v' are the address and value of the access that triggered a
+// watchpoint. An empty expression is always true.
+uint32_t Expression::eval(const Z80& cpu, uint16_t a, uint8_t v) const
+{
+	uint32_t s[MAX_DEPTH];
+	uint n = 0;
+	Z80::Registers r(cpu.getRegisters());
+
+	if(code_.empty())
+	{
+		return 1;
+	}
+
+	for(const Code& c : code_)
+	{
+		switch(c.op)
+		{
+			case Op::NUM:   s[n++] = c.arg; continue;
+			case Op::REG:   s[n++] = reg(r, c.arg); continue;
+			case Op::FLAG:  s[n++] = (r.AF & c.arg) ? 1 : 0; continue;
+			case Op::ADDR:  s[n++] = a; continue;
+			case Op::VALUE: s[n++] = v; continue;
+			default: break;
+		}
+
+		uint32_t& x(s[n - 1]);
+
+		switch(c.op)
+		{
+			case Op::MEM: x = cpu.peek(x); continue;
+			case Op::WORD: x = cpu.peek(x) | (cpu.peek(x + 1) << 8); continue;
+			case Op::NEG: x = -x; continue;
+			case Op::NOT: x = !x; continue;
+			case Op::INV: x = ~x; continue;
+			default: break;
+		}
+
+		uint32_t y = x;
+		uint32_t& l(s[--n - 1]);
+
+		switch(c.op)
+		{
+			case Op::MUL:  l *= y; break;
+			case Op::DIV:  l = y ? l / y : 0; break;
+			case Op::MOD:  l = y ? l % y : 0; break;
+			case Op::ADD:  l += y; break;
+			case Op::SUB:  l -= y; break;
+			case Op::SHL:  l = y < 32 ? l << y : 0; break;
+			case Op::SHR:  l = y < 32 ? l >> y : 0; break;
+			case Op::LT:   l = l < y; break;
+			case Op::LE:   l = l <= y; break;
+			case Op::GT:   l = l > y; break;
+			case Op::GE:   l = l >= y; break;
+			case Op::EQ:   l = l == y; break;
+			case Op::NE:   l = l != y; break;
+			case Op::AND:  l &= y; break;
+			case Op::XOR:  l ^= y; break;
+			case Op::OR:   l |= y; break;
+			case Op::LAND: l = l && y; break;
+			case Op::LOR:  l = l || y; break;
+			default: break;
+		}
+	}
+
+	return s[0];
+}
+
+}
+
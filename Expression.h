@@ -0,0 +1,55 @@
+#ifndef Z80_EXPRESSION_H
+#define Z80_EXPRESSION_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "Command.h"
+
+namespace z80
+{
+	class Z80;
+
+	// A condition on the state of the cpu. It gets parsed once, into the
+	// code of a small stack machine, so evaluating it on every hit of a
+	// breakpoint is a single pass over a handful of opcodes.
+	// It knows the registers (a, hl, ix, sp, ...), the flags (sf, zf, hf,
+	// pf, nf, cf), bytes and words of memory (mem(...), word(...)) and,
+	// for watchpoints, the address and value of the access (addr, value).
+	// The operators are C's, with C's precedence; comparisons and logical
+	// operators yield 0 or 1.
+	class Expression
+	{
+		public:
+			enum class Op : uint8_t
+			{
+				NUM, REG, FLAG, ADDR, VALUE, MEM, WORD,
+				NEG, NOT, INV,
+				MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+				LT, LE, GT, GE, EQ, NE,
+				AND, XOR, OR, LAND, LOR
+			};
+
+			struct Code
+			{
+				Op op;
+				uint32_t arg;
+			};
+
+			static const uint MAX_DEPTH = 16;
+
+		public:
+			Expression( ) { }
+			Expression(const Tokenizer&, size_t);
+			bool empty( ) const { return code_.empty(); }
+			const std::string& toString( ) const { return src_; }
+			uint32_t eval(const Z80&, uint16_t = 0, uint8_t = 0) const;
+		private:
+			std::vector<Code> code_;
+			std::string src_;
+	};
+}
+
+#endif
+
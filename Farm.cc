@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <thread>
+
+#include "Farm.h"
+#include "Timer.h"
+#include "lib.h"
+
+namespace z80 {
+
+Farm::Farm(uint n, uint threads)
+	: left_(0)
+	, steals_(0)
+	, quantum_(QUANTUM)
+	, seconds_(0)
+{
+	if(!n)
+	{
+		throw std::string("A farm needs at least one machine!");
+	}
+
+	if(!threads) threads = std::thread::hardware_concurrency();
+	if(!threads) threads = 1;
+
+	threads = std::min(threads, n);
+
+	for(uint i = 0 ; i < n ; ++i)
+	{
+		machines_.emplace_back(new Machine);
+	}
+
+	for(uint i = 0 ; i < threads ; ++i)
+	{
+		queues_.emplace_back(new Queue);
+	}
+}
+
+// Runs every machine for 't' T-states or until it halts.
+const std::vector<Farm::Result>& Farm::run(uint64_t t)
+{
+	std::vector<std::thread> workers;
+	Timer timer;
+
+	results_.assign(size(), Result());
+	left_ = size();
+	steals_ = 0;
+
+	for(uint i = 0 ; i < size() ; ++i)
+	{
+		queues_[i % queues_.size()]->ids.push_back(i);
+	}
+
+	timer.reset();
+
+	for(uint w = 1 ; w < queues_.size() ; ++w)
+	{
+		workers.emplace_back(&Farm::work, this, w, t);
+	}
+
+	work(0, t);
+
+	for(std::thread& w : workers)
+	{
+		w.join();
+	}
+
+	seconds_ = timer.get().count() / 1000000.0;
+
+	return results_;
+}
+
+void Farm::work(uint w, uint64_t t)
+{
+	uint id;
+
+	while(left_)
+	{
+		if(next(w, id))
+		{
+			quantum(w, id, t);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+// A worker keeps running the machine it ran last, since its state is
+// still in the cache; thieves take the one that waited longest.
+bool Farm::next(uint w, uint& id)
+{
+	for(uint i = 0 ; i < queues_.size() ; ++i)
+	{
+		Queue& q(*queues_[(w + i) % queues_.size()]);
+		std::lock_guard<std::mutex> guard(q.lock);
+
+		if(!q.ids.empty())
+		{
+			if(i)
+			{
+				id = q.ids.front();
+				q.ids.pop_front();
+				++steals_;
+			}
+			else
+			{
+				id = q.ids.back();
+				q.ids.pop_back();
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Only the worker that dequeued a machine touches it or its result.
+void Farm::quantum(uint w, uint id, uint64_t t)
+{
+	Result& r(results_[id]);
+
+	try
+	{
+		Machine::Result m = machines_[id]->run(std::min(quantum_, t - r.cycles));
+
+		r.cycles += m.cycles;
+		r.seconds += m.seconds;
+		r.halted = m.stop == Z80::Stop::HALT;
+	}
+	catch(const std::string& e)
+	{
+		r.error = e;
+	}
+
+	++r.quanta;
+
+	if(r.halted || r.cycles >= t || !r.error.empty())
+	{
+		--left_;
+	}
+	else
+	{
+		Queue& q(*queues_[w]);
+		std::lock_guard<std::mutex> guard(q.lock);
+
+		q.ids.push_back(id);
+	}
+}
+
+void Farm::print(std::ostream& os) const
+{
+	uint64_t total = 0;
+
+	for(uint i = 0 ; i < results_.size() ; ++i)
+	{
+		const Result& r(results_[i]);
+
+		os << lib::stringf("#%-4u %12llu cycles %6u quanta %8.3fs %s\n",
+			i, (unsigned long long) r.cycles, r.quanta, r.seconds,
+			!r.error.empty() ? ("ERR: " + r.error).c_str() : r.halted ? "halted" : "");
+
+		total += r.cycles;
+	}
+
+	os << lib::stringf("\n%u machines on %u threads: %llu cycles in %.3fs (%.2f MHz), %llu steals\n",
+		size(), getThreads(), (unsigned long long) total, seconds_,
+		seconds_ > 0 ? total / seconds_ / 1000000.0 : 0.0, (unsigned long long) steals_);
+}
+
+}
+
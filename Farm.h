@@ -0,0 +1,69 @@
+#ifndef Z80_FARM_H
+#define Z80_FARM_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include <string>
+
+#include "Machine.h"
+
+namespace z80
+{
+	// Runs a number of independent machines on all cores. Every machine
+	// is advanced in quanta of a fixed number of T-states; a quantum is
+	// the unit of work the pool schedules. Each worker keeps its own queue
+	// of machines and steals from the others once it runs dry, so
+	// machines that halt early don't leave cores idle.
+	class Farm
+	{
+		public:
+			static const uint64_t QUANTUM = 1000000;
+
+			struct Result
+			{
+				uint64_t cycles;
+				uint quanta;
+				double seconds;
+				bool halted;
+				std::string error;
+			};
+
+		public:
+			explicit Farm(uint, uint = 0);
+			uint size( ) const { return machines_.size(); }
+			uint getThreads( ) const { return queues_.size(); }
+			Machine& operator[](uint i) { return *machines_.at(i); }
+			void setQuantum(uint64_t q) { quantum_ = q; }
+			const std::vector<Result>& run(uint64_t);
+			const std::vector<Result>& getResults( ) const { return results_; }
+			uint64_t getSteals( ) const { return steals_; }
+			double getSeconds( ) const { return seconds_; }
+			void print(std::ostream&) const;
+		private:
+			struct Queue
+			{
+				std::mutex lock;
+				std::deque<uint> ids;
+			};
+
+			void work(uint, uint64_t);
+			bool next(uint, uint&);
+			void quantum(uint, uint, uint64_t);
+
+		private:
+			std::vector<std::unique_ptr<Machine>> machines_;
+			std::vector<std::unique_ptr<Queue>> queues_;
+			std::vector<Result> results_;
+			std::atomic<uint> left_;
+			std::atomic<uint64_t> steals_;
+			uint64_t quantum_;
+			double seconds_;
+	};
+}
+
+#endif
+
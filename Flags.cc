@@ -0,0 +1,12 @@
+#include "Flags.h"
+
+namespace z80 {
+
+constexpr flags::Table<0x100> Flags::SZP;
+constexpr flags::Table<0x100> Flags::INC;
+constexpr flags::Table<0x100> Flags::DEC;
+constexpr flags::Table<0x20000> Flags::ADD;
+constexpr flags::Table<0x20000> Flags::SUB;
+
+}
+
@@ -0,0 +1,136 @@
+#ifndef Z80_FLAGS_H
+#define Z80_FLAGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	namespace flags
+	{
+		static const uint8_t S  = 0x80;
+		static const uint8_t Z  = 0x40;
+		static const uint8_t H  = 0x10;
+		static const uint8_t PV = 0x04;
+		static const uint8_t N  = 0x02;
+		static const uint8_t C  = 0x01;
+
+		template<size_t L>
+		struct Table
+		{
+			uint8_t v[L];
+
+			constexpr uint8_t operator[](size_t i) const { return v[i]; }
+		};
+
+		constexpr uint8_t sz(uint r)
+		{
+			return (r & S) | ((r & 0xFF) ? 0 : Z);
+		}
+
+		constexpr Table<0x100> make_szp( )
+		{
+			Table<0x100> t{};
+
+			for(uint i = 0 ; i < 0x100 ; ++i)
+			{
+				uint p = i ^ (i >> 4);
+				p ^= p >> 2;
+				p ^= p >> 1;
+				t.v[i] = sz(i) | ((p & 1) ? 0 : PV);
+			}
+
+			return t;
+		}
+
+		// indexed by the result of the increment
+		constexpr Table<0x100> make_inc( )
+		{
+			Table<0x100> t{};
+
+			for(uint i = 0 ; i < 0x100 ; ++i)
+			{
+				t.v[i] = sz(i) | ((i & 0x0F) == 0 ? H : 0) | (i == 0x80 ? PV : 0);
+			}
+
+			return t;
+		}
+
+		// indexed by the result of the decrement
+		constexpr Table<0x100> make_dec( )
+		{
+			Table<0x100> t{};
+
+			for(uint i = 0 ; i < 0x100 ; ++i)
+			{
+				t.v[i] = sz(i) | ((i & 0x0F) == 0x0F ? H : 0) | (i == 0x7F ? PV : 0) | N;
+			}
+
+			return t;
+		}
+
+		// indexed by (carry << 16) | (a << 8) | operand
+		constexpr Table<0x20000> make_add( )
+		{
+			Table<0x20000> t{};
+
+			for(uint c = 0 ; c < 2 ; ++c)
+			{
+				for(uint a = 0 ; a < 0x100 ; ++a)
+				{
+					for(uint v = 0 ; v < 0x100 ; ++v)
+					{
+						uint r = a + v + c;
+						uint cIn = (a ^ v ^ r) >> 7;
+
+						t.v[(c << 16) | (a << 8) | v] =
+							sz(r) | ((a ^ v ^ r) & H) | (((cIn ^ (r >> 8)) & 1) ? PV : 0) | (r >> 8);
+					}
+				}
+			}
+
+			return t;
+		}
+
+		// Subtraction is an addition of the complement with the carry
+		// inverted on the way in and out.
+		constexpr Table<0x20000> make_sub( )
+		{
+			Table<0x20000> t{};
+			Table<0x20000> add = make_add();
+
+			for(uint c = 0 ; c < 2 ; ++c)
+			{
+				for(uint a = 0 ; a < 0x100 ; ++a)
+				{
+					for(uint v = 0 ; v < 0x100 ; ++v)
+					{
+						t.v[(c << 16) | (a << 8) | v] = (add[((c ^ 1) << 16) | (a << 8) | (v ^ 0xFF)] ^ C) | N;
+					}
+				}
+			}
+
+			return t;
+		}
+	}
+
+	// Flag bytes of the 8-bit ALU, built at compile time. Entries never set
+	// the undocumented bits 3 and 5; callers keep those from the old F.
+	struct Flags
+	{
+		static const uint8_t KEEP = 0x28;
+
+		static constexpr flags::Table<0x100> SZP = flags::make_szp();
+		static constexpr flags::Table<0x100> INC = flags::make_inc();
+		static constexpr flags::Table<0x100> DEC = flags::make_dec();
+		static constexpr flags::Table<0x20000> ADD = flags::make_add();
+		static constexpr flags::Table<0x20000> SUB = flags::make_sub();
+
+		static uint index(uint c, uint8_t a, uint8_t v) { return (c << 16) | (a << 8) | v; }
+	};
+}
+
+#endif
+
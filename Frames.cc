@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <string>
+
+#include "Frames.h"
+#include "Thread.h"
+
+namespace z80 {
+
+Frames::Frames(void)
+	: back_(0)
+	, ready_(1)
+	, front_(2)
+	, fresh_(false)
+{
+	if((mtx_ = SDL_CreateMutex()) == nullptr)
+	{
+		throw std::string("ERR: couldn't create mutex! ") + SDL_GetError();
+	}
+}
+
+Frames::~Frames(void)
+{
+	SDL_DestroyMutex(mtx_);
+}
+
+// Called by the emulation thread once the back buffer is filled in.
+void Frames::publish(void)
+{
+	lib::Lock lock(mtx_);
+
+	std::swap(back_, ready_);
+	fresh_ = true;
+}
+
+// Called by the UI thread before it renders. Returns whether there was
+// a newer frame than the one it already had.
+bool Frames::acquire(void)
+{
+	lib::Lock lock(mtx_);
+
+	if(!fresh_)
+	{
+		return false;
+	}
+
+	std::swap(front_, ready_);
+	fresh_ = false;
+
+	return true;
+}
+
+}
+
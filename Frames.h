@@ -0,0 +1,56 @@
+#ifndef Z80_FRAMES_H
+#define Z80_FRAMES_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <SDL.h>
+
+#include "Z80.h"
+#include "Screen.h"
+
+namespace z80
+{
+	// What the UI gets to see of the machine: copies of the cpu and the
+	// screen, taken by the emulation thread once per frame. Copies share
+	// RAM and VRAM with the original until it writes to them, so taking
+	// one is cheap.
+	// The emulation thread fills the back buffer and publishes it; the UI
+	// picks up the latest one before it renders and reads it without
+	// holding the lock. A spare buffer between the two means neither side
+	// ever has to wait for the other to finish with its own.
+	class Frames
+	{
+		public:
+			struct Frame
+			{
+				Z80 cpu;
+				Screen screen;
+				std::vector<uint8_t> heat;
+				std::string speed;
+				double mhz = 0;
+				bool history = false;
+			};
+
+		public:
+			Frames( );
+			~Frames( );
+			Frame& back( ) { return frames_[back_]; }
+			Frame& front( ) { return frames_[front_]; }
+			void publish( );
+			bool acquire( );
+		private:
+			Frames(const Frames&) = delete;
+			Frames& operator=(const Frames&) = delete;
+
+		private:
+			Frame frames_[3];
+			uint back_, ready_, front_;
+			bool fresh_;
+			SDL_mutex *mtx_;
+	};
+}
+
+#endif
+
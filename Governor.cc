@@ -0,0 +1,123 @@
+#include <string>
+
+#include "Governor.h"
+#include "lib.h"
+
+namespace z80 {
+
+Governor::Governor(void)
+	: mode_(Mode::EXACT)
+	, clock_(Z80::CLOCK)
+	, baseCycles_(0)
+	, baseTime_(0)
+	, sampleCycles_(0)
+	, sampleTime_(0)
+	, mhz_(0)
+{
+	timer_.reset();
+}
+
+// Changing the mode takes a sync to take effect.
+void Governor::setExact(uint64_t hz)
+{
+	if(!hz)
+	{
+		throw std::string("Invalid clock!");
+	}
+
+	mode_ = Mode::EXACT;
+	clock_ = hz;
+}
+
+void Governor::setMultiplied(uint n)
+{
+	if(!n)
+	{
+		throw std::string("Invalid multiplier!");
+	}
+
+	mode_ = Mode::MULTIPLIED;
+	clock_ = Z80::CLOCK * n;
+}
+
+void Governor::setTurbo(void)
+{
+	mode_ = Mode::TURBO;
+}
+
+std::string Governor::toString(void) const
+{
+	switch(mode_)
+	{
+		case Mode::EXACT:
+			return lib::stringf("exact %.3f MHz", clock_ / 1000000.0);
+		case Mode::MULTIPLIED:
+			return lib::stringf("%ux (%.3f MHz)", (uint) (clock_ / Z80::CLOCK), clock_ / 1000000.0);
+		case Mode::TURBO:
+			return "turbo";
+	}
+
+	return "";
+}
+
+// Starts pacing afresh from 'cycles', for whenever the cpu was stopped
+// or its clock jumped.
+void Governor::sync(uint64_t cycles)
+{
+	baseCycles_ = cycles;
+	baseTime_ = timer_.get().count();
+}
+
+// Returns how many cycles the cpu may run right now. If that is none,
+// 'wait' is set to the microseconds until it's worth asking again.
+uint64_t Governor::getBudget(uint64_t cycles, uint64_t& wait)
+{
+	wait = 0;
+
+	if(mode_ == Mode::TURBO)
+	{
+		return (uint64_t) -1;
+	}
+
+	uint64_t now = timer_.get().count();
+	uint64_t lag = LAG * clock_ / 1000000;
+	uint64_t allowed = baseCycles_ + (now - baseTime_) * clock_ / 1000000;
+
+	// rebasing now and then keeps the products from overflowing
+	if(now - baseTime_ >= 1000000)
+	{
+		baseCycles_ = allowed;
+		baseTime_ = now;
+	}
+
+	if(allowed > cycles + lag)
+	{
+		baseCycles_ = allowed = cycles + lag;
+		baseTime_ = now;
+	}
+
+	if(allowed > cycles)
+	{
+		return allowed - cycles;
+	}
+
+	wait = (cycles - allowed) * 1000000 / clock_ + MIN_RUN;
+
+	return 0;
+}
+
+// Keeps track of the clock the guest effectively runs at.
+void Governor::measure(uint64_t cycles)
+{
+	uint64_t now = timer_.get().count();
+
+	if(now - sampleTime_ >= SAMPLE)
+	{
+		mhz_ = cycles >= sampleCycles_ ? (double) (cycles - sampleCycles_) / (now - sampleTime_) : 0;
+		sampleCycles_ = cycles;
+		sampleTime_ = now;
+	}
+}
+
+}
+
@@ -0,0 +1,56 @@
+#ifndef Z80_GOVERNOR_H
+#define Z80_GOVERNOR_H
+
+#include <string>
+#include <stdint.h>
+
+#include "Z80.h"
+#include "Timer.h"
+
+namespace z80
+{
+	// Paces the guest against the host clock. The cpu may run as many
+	// cycles as the target clock would have since the governor was last
+	// synced, so oversleeping on the host evens out instead of adding up
+	// to drift. A host that falls more than LAG behind gives up on the
+	// missed time rather than racing to catch up. Exact mode runs at a
+	// given clock, multiplied mode at a multiple of the board's clock and
+	// turbo mode doesn't pace at all.
+	class Governor
+	{
+		public:
+			enum class Mode
+			{
+				EXACT,
+				MULTIPLIED,
+				TURBO
+			};
+
+			static const uint64_t LAG = 50000;
+			static const uint64_t MIN_RUN = 500;
+			static const uint64_t SAMPLE = 500000;
+
+		public:
+			Governor( );
+			void setExact(uint64_t);
+			void setMultiplied(uint);
+			void setTurbo( );
+			Mode getMode( ) const { return mode_; }
+			uint64_t getClock( ) const { return clock_; }
+			std::string toString( ) const;
+			void sync(uint64_t);
+			uint64_t getBudget(uint64_t, uint64_t&);
+			void measure(uint64_t);
+			double getMHz( ) const { return mhz_; }
+		private:
+			Timer timer_;
+			Mode mode_;
+			uint64_t clock_;
+			uint64_t baseCycles_, baseTime_;
+			uint64_t sampleCycles_, sampleTime_;
+			double mhz_;
+	};
+}
+
+#endif
+
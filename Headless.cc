@@ -0,0 +1,269 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <vector>
+#include <memory>
+
+#include "Machine.h"
+#include "Farm.h"
+#include "Tracer.h"
+#include "Disassemble.h"
+#include "Timer.h"
+#include "lib.h"
+
+#define MXT_DEFAULT_CYCLES 100000000ull
+#define MXT_FORK_CYCLES 10000
+#define MXT_USAGE "usage: %s PROGRAM.BIN|-r SNAPSHOT [-a ADDR] [-c CYCLES] [-f FRAME-CYCLES] [-d switch|table|block|jit] [-n MACHINES] [-j THREADS] [-s SNAPSHOT] [-k FORKS] [-x PASSES] [-t TRACE] [-o FILE]"
+
+using namespace z80;
+
+namespace
+{
+	uint64_t number(const char *s)
+	{
+		char *e = nullptr;
+		uint64_t v = strtoull(s, &e, 0);
+
+		if(!*s || *e)
+		{
+			throw lib::stringf("Invalid number '%s'!", s);
+		}
+
+		return v;
+	}
+
+	Z80::Dispatch dispatch(const std::string& s)
+	{
+		if(s == "switch") return Z80::Dispatch::SWITCH;
+		if(s == "table") return Z80::Dispatch::TABLE;
+		if(s == "block") return Z80::Dispatch::BLOCK;
+		if(s == "jit") return Z80::Dispatch::JIT;
+
+		throw std::string("Unknown dispatch '") + s + "'!";
+	}
+
+	size_t footprint(const std::vector<std::unique_ptr<Machine>>& v)
+	{
+		size_t n = 0;
+
+		for(const auto& m : v) n += m->getFootprint();
+
+		return n / v.size();
+	}
+
+	// Forks the machine 'n' times, then lets every fork run on its own
+	// for a little while to see how much of its memory it takes private.
+	void benchmark(std::ostream& os, const Machine& m, uint n)
+	{
+		std::vector<std::unique_ptr<Machine>> v;
+		Timer timer;
+
+		v.reserve(n);
+		timer.reset();
+
+		for(uint i = 0 ; i < n ; ++i)
+		{
+			v.push_back(m.fork());
+		}
+
+		double s = std::max<long>(timer.get().count(), 1) / 1000000.0;
+
+		os << lib::stringf("\nForked %u times in %.3fs (%.0f forks/s), %u bytes per fork\n",
+			n, s, n / s, (uint) footprint(v));
+
+		for(auto& f : v)
+		{
+			f->run(MXT_FORK_CYCLES);
+		}
+
+		os << lib::stringf("%u bytes per fork after %u more cycles each\n", (uint) footprint(v), MXT_FORK_CYCLES);
+	}
+
+	// Disassembles all of the memory 'n' times over, decoding and
+	// formatting one instruction after the other.
+	void disassembly(std::ostream& os, Machine& m, uint n)
+	{
+		std::vector<uint8_t> mem(0x10000);
+		char buf[Decoded::MAX_TEXT];
+		Decoded d;
+		uint64_t count = 0, chars = 0;
+		Timer timer;
+
+		for(uint a = 0 ; a < 0x10000 ; ++a)
+		{
+			mem[a] = m.CPU().peek(a);
+		}
+
+		timer.reset();
+
+		for(uint i = 0 ; i < n ; ++i)
+		{
+			for(uint a = 0 ; a < 0x10000 ; a += d.size)
+			{
+				decode(mem.data() + a, 0x10000 - a, d);
+				chars += format(d, buf, sizeof(buf));
+				++count;
+			}
+		}
+
+		double ms = timer.get().count() / 1000.0 / n;
+
+		os << lib::stringf("\nDisassembled 64 KiB (%llu instructions, %llu characters) in %.3fms per pass\n",
+			(unsigned long long) (count / n), (unsigned long long) (chars / n), ms);
+	}
+}
+
+// Runs a single program without any windows and dumps the final state.
+int main(int argc, char *argv[])
+try
+{
+	std::string prg, out, snap, save, trace;
+	uint16_t addr = 0;
+	uint64_t cycles = MXT_DEFAULT_CYCLES, frame = 0;
+	uint machines = 1, threads = 0, forks = 0, passes = 0;
+	Z80::Dispatch d = Z80::DISPATCH;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		std::string a(argv[i]);
+
+		if(a.size() == 2 && a[0] == '-' && i + 1 < argc)
+		{
+			const char *v = argv[++i];
+
+			switch(a[1])
+			{
+				case 'a': addr = number(v) & 0xFFFF; break;
+				case 'c': cycles = number(v); break;
+				case 'f': frame = number(v); break;
+				case 'd': d = dispatch(v); break;
+				case 'n': machines = number(v); break;
+				case 'j': threads = number(v); break;
+				case 'o': out = v; break;
+				case 'r': snap = v; break;
+				case 's': save = v; break;
+				case 'k': forks = number(v); break;
+				case 'x': passes = number(v); break;
+				case 't': trace = v; break;
+				default: throw lib::stringf(MXT_USAGE, argv[0]);
+			}
+		}
+		else if(prg.empty() && a[0] != '-')
+		{
+			prg = a;
+		}
+		else
+		{
+			throw lib::stringf(MXT_USAGE, argv[0]);
+		}
+	}
+
+	// saving, forking, disassembling and tracing work on a single machine
+	bool single = !save.empty() || forks || passes || !trace.empty();
+
+	if(prg.empty() == snap.empty() || (machines > 1 && single))
+	{
+		throw lib::stringf(MXT_USAGE, argv[0]);
+	}
+
+	Snapshot s;
+
+	if(!snap.empty())
+	{
+		s.load(snap);
+	}
+
+	// every machine starts out from either the program or the snapshot
+	auto setup = [&](Machine& m)
+	{
+		m.CPU().setDispatch(d);
+		m.setFrame(frame);
+
+		if(snap.empty())
+		{
+			m.load(prg, addr);
+		}
+		else
+		{
+			m.restore(s);
+		}
+	};
+
+	std::ofstream f;
+
+	if(!out.empty())
+	{
+		f.open(out);
+
+		if(!f)
+		{
+			throw std::string("Can't open '") + out + "'!";
+		}
+	}
+
+	std::ostream& os(out.empty() ? std::cout : f);
+
+	if(machines > 1)
+	{
+		Farm farm(machines, threads);
+
+		for(uint i = 0 ; i < farm.size() ; ++i)
+		{
+			setup(farm[i]);
+		}
+
+		farm.run(cycles);
+		farm.print(os);
+	}
+	else
+	{
+		Machine m;
+
+		setup(m);
+
+		std::unique_ptr<Tracer> tracer;
+
+		if(!trace.empty())
+		{
+			tracer.reset(new Tracer(m.CPU(), trace));
+		}
+
+		Machine::Result r = m.run(cycles);
+
+		if(tracer)
+		{
+			tracer->flush();
+			os << lib::stringf("Traced %llu instructions to '%s'\n", (unsigned long long) tracer->getRecords(), trace.c_str());
+			tracer.reset();
+		}
+
+		if(!save.empty())
+		{
+			Snapshot snapshot;
+
+			m.save(snapshot);
+			snapshot.save(save);
+		}
+
+		m.print(os, r);
+
+		if(forks)
+		{
+			benchmark(os, m, forks);
+		}
+
+		if(passes)
+		{
+			disassembly(os, m, passes);
+		}
+	}
+
+	return 0;
+}
+catch(const std::string& e)
+{
+	std::cerr << e << std::endl;
+
+	return 1;
+}
+
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <SDL.h>
 
 #include "Keyboard.h"
@@ -52,7 +54,7 @@ Keyboard::Keyboard(void)
 	if(!initialized)
 	{
 	    init();
-		initialized = false;
+		initialized = true;
 	}
 }
 
@@ -193,6 +195,35 @@ void Keyboard::reset(void)
 	intLine_.set(false);
 }
 
+// The interrupt line is left alone; the status port has already
+// latched whatever it signalled.
+void Keyboard::save(Snapshot& s) const
+{
+	s.write32(buf_.size());
+	for(uint8_t c : buf_) s.write8(c);
+	s.write32(pressed_.size());
+	for(uint8_t c : pressed_) s.write8(c);
+	s.write8(mode_);
+	s.write8(poll_);
+	s.write8((shift_ ? MXT_SHIFT : 0) | (ctrl_ ? MXT_CTRL : 0) | (alt_ ? MXT_ALT : 0));
+}
+
+void Keyboard::restore(Snapshot& s)
+{
+	buf_.resize(s.readCount());
+	for(uint8_t& c : buf_) c = s.read8();
+	pressed_.resize(s.readCount());
+	for(uint8_t& c : pressed_) c = s.read8();
+	mode_ = s.read8();
+	poll_ = s.read8();
+
+	uint8_t m = s.read8();
+
+	shift_ = m & MXT_SHIFT;
+	ctrl_ = m & MXT_CTRL;
+	alt_ = m & MXT_ALT;
+}
+
 void Keyboard::init(void)
 {
     mSimple[SDLK_a] = 0x1C;
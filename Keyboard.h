@@ -3,10 +3,11 @@
 
 #include <map>
 #include <deque>
+#include <vector>
 
-#include "WinUI.h"
 #include "Peripheral.h"
 #include "Property.h"
+#include "Snapshot.h"
 
 namespace z80
 {
@@ -26,6 +27,8 @@ namespace z80
 			void write(uint8_t, uint8_t);
 			uint8_t read(uint8_t);
 			void reset( );
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
 		private:
 			uint8_t getASCII(uint) const;
 			static void init( );
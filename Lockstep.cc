@@ -0,0 +1,73 @@
+#include <memory>
+#include <sstream>
+
+#include "Lockstep.h"
+#include "lib.h"
+
+#define MXT_INT_PERIOD 64
+
+namespace z80 {
+
+LockstepResult lockstep(const Z80& cpu, uint64_t instructions)
+{
+	std::unique_ptr<Z80> jit(new Z80(cpu)), ref(new Z80(cpu));
+	LockstepResult r;
+
+	jit->clearPeripherals();
+	ref->clearPeripherals();
+	jit->getBreakpoints().clear();
+	ref->getBreakpoints().clear();
+	jit->getWatchpoints().clear();
+	ref->getWatchpoints().clear();
+	jit->setDispatch(Z80::Dispatch::JIT);
+	ref->setDispatch(Z80::Dispatch::TABLE);
+
+	r.instructions = 0;
+
+	for(uint64_t s = 0 ; r.instructions < instructions ; ++s)
+	{
+		if(jit->isHalted())
+		{
+			jit->restart();
+			ref->restart();
+		}
+
+		// exercise interrupt boundaries
+		if(s % MXT_INT_PERIOD == 0)
+		{
+			jit->interrupt();
+			ref->interrupt();
+		}
+
+		uint16_t pc = jit->getPC();
+		uint n = jit->step();
+
+		for(uint i = 0 ; i < n ; ++i)
+		{
+			ref->execute();
+		}
+
+		if(!jit->sameState(*ref))
+		{
+			std::ostringstream os;
+
+			os << lib::stringf("JIT diverged from the interpreter after %llu instructions, in a step of %u starting @$%04X.\n",
+				(unsigned long long) r.instructions, n, pc);
+			os << "JIT:\n";
+			jit->printStatus(os);
+			os << "Interpreter:\n";
+			ref->printStatus(os);
+
+			throw os.str();
+		}
+
+		r.instructions += n;
+	}
+
+	r.native = jit->getNativeInstructions();
+
+	return r;
+}
+
+}
+
@@ -0,0 +1,24 @@
+#ifndef Z80_LOCKSTEP_H
+#define Z80_LOCKSTEP_H
+
+#include <stdint.h>
+
+#include "Z80.h"
+
+namespace z80
+{
+	struct LockstepResult
+	{
+		uint64_t instructions;
+		uint64_t native;
+	};
+
+	// Differential test of the recompiler: runs two detached copies of
+	// 'cpu' side by side, one in JIT mode and one through the table
+	// interpreter, and compares the complete machine state after every
+	// step of the JIT copy. Throws a description of the first divergence.
+	LockstepResult lockstep(const Z80& cpu, uint64_t instructions);
+}
+
+#endif
+
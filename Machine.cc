@@ -0,0 +1,220 @@
+#include <algorithm>
+
+#include "Machine.h"
+#include "Program.h"
+#include "Timer.h"
+#include "lib.h"
+
+#define MXT_SLICE 10000
+#define MXT_MAX_CYCLES 23
+
+namespace z80 {
+
+Machine::Machine(void)
+	: frame_(0)
+	, vsyncEvent_(0)
+{
+	connect();
+
+	status_.onInt([this]( ) { cpu_.interrupt(); });
+	status_.registerInt(0x01, vsync_);
+	status_.registerInt(0x02, keyboard_.keyPressedInt());
+
+	cpu_.clear();
+	reset();
+}
+
+void Machine::connect(void)
+{
+	cpu_.clearPeripherals();
+	cpu_.registerPeripheral(0x00, status_);
+	cpu_.registerPeripheral(0x10, screen_);
+	cpu_.registerPeripheral(0x20, keyboard_);
+}
+
+void Machine::reset(void)
+{
+	cpu_.reset();
+	screen_.reset();
+	keyboard_.reset();
+	status_.reset();
+}
+
+void Machine::load(const std::string& fn, uint16_t addr)
+{
+	Program prg(fn);
+
+	cpu_.loadRAM(addr, prg);
+}
+
+// Same layout as the snapshots of the simulator, so either can restore
+// the other's.
+void Machine::save(Snapshot& s) const
+{
+	cpu_.save(s);
+	screen_.save(s);
+	keyboard_.save(s);
+	status_.save(s);
+}
+
+// Nothing is overwritten unless the whole snapshot decodes, so a corrupt
+// one leaves the machine as it was.
+void Machine::restore(Snapshot& s)
+{
+	check(s);
+	decode(s);
+	setFrame(frame_);
+}
+
+// Decodes the snapshot into a scratch machine and throws if any of it
+// is broken.
+void Machine::check(Snapshot& s)
+{
+	Machine m;
+
+	m.decode(s);
+}
+
+void Machine::decode(Snapshot& s)
+{
+	s.rewind();
+	cpu_.restore(s);
+	screen_.restore(s);
+	keyboard_.restore(s);
+	status_.restore(s);
+
+	if(!s.isAtEnd())
+	{
+		throw std::string("Snapshot has trailing data!");
+	}
+}
+
+// A copy of the machine that shares the RAM and VRAM pages with this one
+// until either side writes to them.
+std::unique_ptr<Machine> Machine::fork(void) const
+{
+	std::unique_ptr<Machine> m(new Machine);
+	Snapshot s;
+
+	m->cpu_ = cpu_;
+	m->screen_ = screen_;
+	m->connect();
+
+	keyboard_.save(s);
+	status_.save(s);
+	s.rewind();
+	m->keyboard_.restore(s);
+	m->status_.restore(s);
+
+	m->setFrame(frame_);
+
+	return m;
+}
+
+// The memory held by this machine alone.
+size_t Machine::getFootprint(void) const
+{
+	return sizeof(Machine) + cpu_.getMemory().getPrivatePages() * Memory::PAGE_SIZE
+		+ (screen_.isVRAMShared() ? 0 : Screen::COLS * Screen::ROWS);
+}
+
+// Frames start on multiples of the period, so a restored machine sees
+// its interrupts at the same cycles it would have without the break.
+void Machine::setFrame(uint64_t t)
+{
+	if(vsyncEvent_)
+	{
+		cpu_.getEvents().cancel(vsyncEvent_);
+		vsyncEvent_ = 0;
+	}
+
+	if((frame_ = t))
+	{
+		vsyncEvent_ = cpu_.getEvents().schedule([this]( ) { vsync_.set(true); }, t, cpu_.getCycles());
+	}
+}
+
+// Runs for 't' T-states or until the cpu halts or hits a break or watch
+// point. With a frame period set a halt only idles until the next screen
+// interrupt, like on the real board, so it only stops the run if none
+// wakes the cpu within the budget.
+Machine::Result Machine::run(uint64_t t)
+{
+	Result r;
+	Timer timer;
+	uint64_t start = cpu_.getCycles(), end = start + t;
+
+	r.stop = Z80::Stop::BUDGET;
+
+	timer.reset();
+
+	while(cpu_.getCycles() < end)
+	{
+		uint64_t now = cpu_.getCycles();
+		Z80::Stop s;
+
+		if(frame_)
+		{
+			s = cpu_.runFor(end - now);
+		}
+		else
+		{
+			// no instruction takes longer than 23 T-states, so this never
+			// overshoots the budget by more than one instruction
+			uint n = std::min<uint64_t>(MXT_SLICE, (end - now) / MXT_MAX_CYCLES + 1);
+
+			s = cpu_.run(n);
+		}
+
+		// interrupts are just part of the run
+		if(s == Z80::Stop::HALT || s == Z80::Stop::BREAK || s == Z80::Stop::WATCH)
+		{
+			r.stop = s;
+			break;
+		}
+	}
+
+	r.cycles = cpu_.getCycles() - start;
+	r.seconds = timer.get().count() / 1000000.0;
+
+	return r;
+}
+
+void Machine::printScreen(std::ostream& os) const
+{
+	for(uint y = 0 ; y < Screen::ROWS ; ++y)
+	{
+		std::string line;
+
+		for(uint x = 0 ; x < Screen::COLS ; ++x)
+		{
+			uint8_t c = screen_.getChar(x, y);
+
+			line += (c >= 0x20 && c < 0x7F) ? (char) c : ' ';
+		}
+
+		line.erase(line.find_last_not_of(' ') + 1);
+
+		os << line << "\n";
+	}
+}
+
+void Machine::print(std::ostream& os, const Result& r)
+{
+	static const char * const stops[] = { "budget", "halt", "break", "watch", "interrupt" };
+
+	static_assert(sizeof(stops) / sizeof(*stops) == (uint) Z80::Stop::INTERRUPT + 1, "Every stop needs a name!");
+
+	cpu_.printStatus(os);
+
+	os << lib::stringf("\nStopped on %s after %llu cycles in %.3fs (%.2f MHz)\n",
+		stops[(uint) r.stop], (unsigned long long) r.cycles, r.seconds,
+		r.seconds > 0 ? r.cycles / r.seconds / 1000000.0 : 0.0);
+
+	os << lib::stringf("\nScreen (cursor %u,%u):\n", screen_.getCursorX(), screen_.getCursorY());
+
+	printScreen(os);
+}
+
+}
+
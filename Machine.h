@@ -0,0 +1,66 @@
+#ifndef Z80_MACHINE_H
+#define Z80_MACHINE_H
+
+#include <iostream>
+#include <string>
+#include <memory>
+
+#include "z80.h"
+#include "Screen.h"
+#include "Keyboard.h"
+#include "StatusPort.h"
+#include "Property.h"
+#include "Snapshot.h"
+
+namespace z80
+{
+	// The board without any of the windows: the cpu wired to the same
+	// peripherals as in the simulator, with the 60 Hz screen interrupt
+	// derived from the cycle count instead of the wall clock.
+	class Machine
+	{
+		public:
+		typedef lib::Property<bool> int_t;
+
+		struct Result
+		{
+			Z80::Stop stop;
+			uint64_t cycles;
+			double seconds;
+		};
+
+		public:
+			Machine( );
+			Machine(const Machine&) = delete;
+			Machine& operator=(const Machine&) = delete;
+			void reset( );
+			void load(const std::string&, uint16_t = 0);
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
+			static void check(Snapshot&);
+			std::unique_ptr<Machine> fork( ) const;
+			size_t getFootprint( ) const;
+			void setFrame(uint64_t);
+			Result run(uint64_t);
+			void printScreen(std::ostream&) const;
+			void print(std::ostream&, const Result&);
+			Z80& CPU( ) { return cpu_; }
+			Screen& getScreen( ) { return screen_; }
+			Keyboard& getKeyboard( ) { return keyboard_; }
+		private:
+			void connect( );
+			void decode(Snapshot&);
+
+		private:
+			Z80 cpu_;
+			Screen screen_;
+			Keyboard keyboard_;
+			StatusPort status_;
+			int_t vsync_;
+			uint64_t frame_;
+			uint vsyncEvent_;
+	};
+}
+
+#endif
+
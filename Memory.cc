@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <string>
+
+#include "Memory.h"
+
+namespace z80 {
+
+namespace
+{
+	// Shared by all buses, so no two of them ever hand out the same one.
+	std::atomic<uint64_t> generation(0);
+}
+
+Memory::Memory(void)
+{
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		ram_[i] = zero();
+		unmap(i);
+	}
+}
+
+Memory::Memory(const Memory& m)
+{
+	share(m);
+}
+
+Memory& Memory::operator=(const Memory& m)
+{
+	if(this != &m)
+	{
+		share(m);
+	}
+
+	return *this;
+}
+
+bool Memory::sameRAM(const Memory& m) const
+{
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		if(ram_[i] != m.ram_[i] && !std::equal(ram_[i]->data, ram_[i]->data + PAGE_SIZE, m.ram_[i]->data))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// The number of pages of RAM that nobody else shares.
+uint Memory::getPrivatePages(void) const
+{
+	uint n = 0;
+
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		if(ram_[i].use_count() == 1) ++n;
+	}
+
+	return n;
+}
+
+void Memory::clear(void)
+{
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		ram_[i] = zero();
+		refresh(i);
+	}
+}
+
+void Memory::save(Snapshot& s) const
+{
+	std::vector<uint8_t> buf(0x10000);
+
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		std::copy(ram_[i]->data, ram_[i]->data + PAGE_SIZE, buf.begin() + i * PAGE_SIZE);
+	}
+
+	s.write(buf.data(), buf.size());
+}
+
+void Memory::restore(Snapshot& s)
+{
+	std::vector<uint8_t> buf(0x10000);
+
+	s.read(buf.data(), buf.size());
+
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		ram_[i] = std::make_shared<Page>();
+		std::copy(buf.begin() + i * PAGE_SIZE, buf.begin() + (i + 1) * PAGE_SIZE, ram_[i]->data);
+		refresh(i);
+	}
+}
+
+void Memory::mapRAM(uint page, uint8_t *p)
+{
+	if(page >= PAGES) throw std::string("Invalid memory page!");
+
+	read_[page] = write_[page] = p;
+	io_[page] = IO();
+	internal_[page] = false;
+}
+
+void Memory::mapROM(uint page, const uint8_t *p)
+{
+	if(page >= PAGES) throw std::string("Invalid memory page!");
+
+	read_[page] = p;
+	write_[page] = nullptr;
+	io_[page] = IO();
+	internal_[page] = false;
+}
+
+void Memory::mapIO(uint page, read_fn r, write_fn w)
+{
+	if(page >= PAGES) throw std::string("Invalid memory page!");
+
+	read_[page] = nullptr;
+	write_[page] = nullptr;
+	io_[page].read = r;
+	io_[page].write = w;
+	internal_[page] = false;
+}
+
+void Memory::unmap(uint page)
+{
+	if(page >= PAGES) throw std::string("Invalid memory page!");
+
+	io_[page] = IO();
+	internal_[page] = true;
+	refresh(page);
+}
+
+// Gives this bus a private copy of the page if it is shared.
+void Memory::own(uint page)
+{
+	if(ram_[page].use_count() > 1)
+	{
+		ram_[page] = std::make_shared<Page>(*ram_[page]);
+	}
+
+	refresh(page);
+}
+
+// Both sides lose direct write access to the pages they now share.
+void Memory::share(const Memory& m)
+{
+	for(uint i = 0 ; i < PAGES ; ++i)
+	{
+		ram_[i] = m.ram_[i];
+		read_[i] = m.read_[i];
+		write_[i] = m.write_[i];
+		io_[i] = m.io_[i];
+		internal_[i] = m.internal_[i];
+		gen_[i] = m.gen_[i];
+
+		if(internal_[i])
+		{
+			write_[i] = m.write_[i] = nullptr;
+		}
+	}
+}
+
+// Fresh RAM starts out as one zeroed page shared by everybody.
+const std::shared_ptr<Memory::Page>& Memory::zero(void)
+{
+	static std::shared_ptr<Page> page(new Page());
+
+	return page;
+}
+
+void Memory::refresh(uint page)
+{
+	if(internal_[page])
+	{
+		gen_[page] = ++generation;
+		read_[page] = ram_[page]->data;
+		write_[page] = ram_[page].use_count() == 1 ? ram_[page]->data : nullptr;
+	}
+}
+
+void Memory::writeSlow(uint16_t a, uint8_t v)
+{
+	uint p = a >> PAGE_SHIFT;
+
+	if(internal_[p])
+	{
+		own(p);
+		ram_[p]->data[a & (PAGE_SIZE - 1)] = v;
+	}
+	else if(io_[p].write)
+	{
+		io_[p].write(a, v);
+	}
+}
+
+}
+
@@ -0,0 +1,112 @@
+#ifndef Z80_MEMORY_H
+#define Z80_MEMORY_H
+
+#include <functional>
+#include <memory>
+#include <stdint.h>
+
+#include "Snapshot.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// The address space as the cpu sees it: 16 pages of 4 KiB, each
+	// backed by RAM, ROM or a memory mapped device. RAM and ROM pages are
+	// plain pointers, so an access to them is a single dereference; only
+	// device pages go through a handler. Unmapped pages fall back to the
+	// 64 KiB of RAM every bus owns.
+	// That RAM is copy-on-write: a copy shares all of its pages with the
+	// original, and whichever side writes to a shared page first takes the
+	// slow path once to get a private copy of it. External banks and device
+	// handlers are always shared.
+	// Every page of RAM carries a generation that changes whenever it
+	// (re)gains direct write access, so two copies whose page has the same
+	// generation hold the same data in it. Pages that are not RAM have
+	// generation 0, since they can change behind the bus' back.
+	class Memory
+	{
+		public:
+			typedef std::function<uint8_t(uint16_t)> read_fn;
+			typedef std::function<void(uint16_t, uint8_t)> write_fn;
+
+			static const uint PAGE_SHIFT = 12;
+			static const uint PAGE_SIZE = 1 << PAGE_SHIFT;
+			static const uint PAGES = 0x10000 >> PAGE_SHIFT;
+
+		public:
+			Memory( );
+			Memory(const Memory&);
+			Memory& operator=(const Memory&);
+			inline uint8_t read(uint16_t);
+			inline void write(uint16_t, uint8_t);
+			uint8_t peek(uint16_t a) const { const uint8_t *p = read_[a >> PAGE_SHIFT]; return p ? p[a & (PAGE_SIZE - 1)] : 0xFF; }
+			bool isDirect(uint16_t a) const { return read_[a >> PAGE_SHIFT]; }
+			uint64_t getGeneration(uint page) const { return internal_[page] ? gen_[page] : 0; }
+			uint8_t& RAM(uint16_t a) { own(a >> PAGE_SHIFT); return ram_[a >> PAGE_SHIFT]->data[a & (PAGE_SIZE - 1)]; }
+			uint8_t RAM(uint16_t a) const { return ram_[a >> PAGE_SHIFT]->data[a & (PAGE_SIZE - 1)]; }
+			bool sameRAM(const Memory&) const;
+			uint getPrivatePages( ) const;
+			void clear( );
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
+			void mapRAM(uint, uint8_t *);
+			void mapROM(uint, const uint8_t *);
+			void mapIO(uint, read_fn, write_fn);
+			void unmap(uint);
+		private:
+			struct Page
+			{
+				uint8_t data[PAGE_SIZE];
+			};
+
+			struct IO
+			{
+				read_fn read;
+				write_fn write;
+			};
+
+			void own(uint);
+			void share(const Memory&);
+			static const std::shared_ptr<Page>& zero( );
+			void refresh(uint);
+			void writeSlow(uint16_t, uint8_t);
+
+		private:
+			const uint8_t *read_[PAGES];
+			mutable uint8_t *write_[PAGES];
+			IO io_[PAGES];
+			bool internal_[PAGES];
+			uint64_t gen_[PAGES];
+			std::shared_ptr<Page> ram_[PAGES];
+	};
+
+	uint8_t Memory::read(uint16_t a)
+	{
+		const uint8_t *p = read_[a >> PAGE_SHIFT];
+
+		if(p) return p[a & (PAGE_SIZE - 1)];
+
+		IO& io(io_[a >> PAGE_SHIFT]);
+
+		return io.read ? io.read(a) : 0xFF;
+	}
+
+	// Only pages of RAM nobody else shares are directly writable.
+	void Memory::write(uint16_t a, uint8_t v)
+	{
+		uint8_t *p = write_[a >> PAGE_SHIFT];
+
+		if(p)
+		{
+			p[a & (PAGE_SIZE - 1)] = v;
+		}
+		else
+		{
+			writeSlow(a, v);
+		}
+	}
+}
+
+#endif
+
@@ -0,0 +1,2027 @@
+// Z80 instruction set description.
+//
+// Every instruction the core implements is listed exactly once below, grouped
+// by prefix. This file has no include guard on purpose: it is included several
+// times by Z80.h and Z80.cc, each time with a different definition of the
+// Z80_OP_* macros, to generate both the switch based and the table based
+// dispatch engines from the same source.
+//
+// Z80_OP_<TABLE>(opcode, body...)
+//
+//  MAIN  unprefixed opcodes (the prefixes themselves are handled by the engines)
+//  CB    0xCB prefixed opcodes
+//  ED    0xED prefixed opcodes
+//  XY    0xDD/0xFD prefixed opcodes; IXY names IX or IY respectively
+//  XYCB  0xDDCB/0xFDCB prefixed opcodes; t8 holds the displacement byte
+//
+// Bodies may use the scratch registers t8 and t16. Macros that are left
+// undefined by the includer expand to nothing.
+
+#ifndef Z80_OP_MAIN
+#define Z80_OP_MAIN(op, ...)
+#endif
+#ifndef Z80_OP_CB
+#define Z80_OP_CB(op, ...)
+#endif
+#ifndef Z80_OP_ED
+#define Z80_OP_ED(op, ...)
+#endif
+#ifndef Z80_OP_XY
+#define Z80_OP_XY(op, ...)
+#endif
+#ifndef Z80_OP_XYCB
+#define Z80_OP_XYCB(op, ...)
+#endif
+
+// # --------------------------------------------------------------------------- 
+// # Unprefixed
+
+Z80_OP_MAIN(0x00, // nop
+)
+Z80_OP_MAIN(0x01, // ld bc,d16
+	BC = loadW();
+)
+Z80_OP_MAIN(0x02, // ld (bc),a
+	storeB(BC, A());
+)
+Z80_OP_MAIN(0x03, // inc bc
+	++BC;
+)
+Z80_OP_MAIN(0x04, // inc b
+	set_inc_flags(++B());
+)
+Z80_OP_MAIN(0x05, // dec b
+	set_dec_flags(--B());
+)
+Z80_OP_MAIN(0x06, // ld b,d8
+	B() = loadB();
+)
+Z80_OP_MAIN(0x07, // rlca
+	rlca();
+)
+Z80_OP_MAIN(0x08, // ex af,af'
+	swap(AF, AFp);
+)
+Z80_OP_MAIN(0x09, // add hl,bc
+	addHL(BC);
+)
+Z80_OP_MAIN(0x0A, // ld a,(bc)
+	A() = loadB(BC);
+)
+Z80_OP_MAIN(0x0B, // dec bc
+	--BC;
+)
+Z80_OP_MAIN(0x0C, // inc c
+	set_inc_flags(++C());
+)
+Z80_OP_MAIN(0x0D, // dec c
+	set_dec_flags(--C());
+)
+Z80_OP_MAIN(0x0E, // ld c,d8
+	C() = loadB();
+)
+Z80_OP_MAIN(0x0F, // rrca
+	rrca();
+)
+Z80_OP_MAIN(0x10, // djnz d8
+	jr_if(--B());
+)
+Z80_OP_MAIN(0x11, // ld de,d16
+	DE = loadW();
+)
+Z80_OP_MAIN(0x12, // ld (de),d8
+	storeB(DE, A());
+)
+Z80_OP_MAIN(0x13, // inc DE
+	++DE;
+)
+Z80_OP_MAIN(0x14, // inc d
+	set_inc_flags(++D());
+)
+Z80_OP_MAIN(0x15, // dec d
+	set_dec_flags(--D());
+)
+Z80_OP_MAIN(0x16, // ld d,d8
+	D() = loadB();
+)
+Z80_OP_MAIN(0x17, // rla
+	rla();
+)
+Z80_OP_MAIN(0x18, // jr s8
+	jr();
+)
+Z80_OP_MAIN(0x19, // add hl,de
+	addHL(DE);
+)
+Z80_OP_MAIN(0x1A, // ld a,(de)
+	A() = loadB(DE);
+)
+Z80_OP_MAIN(0x1B, // dec de
+	--DE;
+)
+Z80_OP_MAIN(0x1C, // inc e
+	set_inc_flags(++E());
+)
+Z80_OP_MAIN(0x1D, // dec e
+	set_dec_flags(--E());
+)
+Z80_OP_MAIN(0x1E, // ld e,d8
+	E() = loadB();
+)
+Z80_OP_MAIN(0x1F, // rra
+	rra();
+)
+Z80_OP_MAIN(0x20, // jr nz,s8
+	jr_if(!(F() & FLAG_Z));
+)
+Z80_OP_MAIN(0x21, // ld hl,d16
+	HL = loadW();
+)
+Z80_OP_MAIN(0x22, // ld (a16),hl
+	storeW(loadW(), HL);
+)
+Z80_OP_MAIN(0x23, // inc hl
+	++HL;
+)
+Z80_OP_MAIN(0x24, // inc h
+	set_inc_flags(++H());
+)
+Z80_OP_MAIN(0x25, // dec h
+	set_dec_flags(--H());
+)
+Z80_OP_MAIN(0x26, // ld h,d8
+	H() = loadB();
+)
+Z80_OP_MAIN(0x27, // daa
+	daa();
+)
+Z80_OP_MAIN(0x28, // jr z,s8
+	jr_if(F() & FLAG_Z);
+)
+Z80_OP_MAIN(0x29, // add hl,hl
+	addHL(HL);
+)
+Z80_OP_MAIN(0x2A, // ld hl,(a16)
+	HL = loadW(loadW());
+)
+Z80_OP_MAIN(0x2B, // dec hl
+	--HL;
+)
+Z80_OP_MAIN(0x2C, // inc l
+	set_inc_flags(++L());
+)
+Z80_OP_MAIN(0x2D, // dec l
+	set_dec_flags(--L());
+)
+Z80_OP_MAIN(0x2E, // ld l,d8
+	L() = loadB();
+)
+Z80_OP_MAIN(0x2F, // cpl
+	A() = ~A();
+	F() |= FLAG_N | FLAG_H;
+)
+Z80_OP_MAIN(0x30, // jr nc,s8
+	jr_if(!(F() & FLAG_C));
+)
+Z80_OP_MAIN(0x31, // ld sp,d16
+	SP = loadW();
+)
+Z80_OP_MAIN(0x32, // ld (a16),a
+	storeB(loadW(), A());
+)
+Z80_OP_MAIN(0x33, // inc sp
+	++SP;
+)
+Z80_OP_MAIN(0x34, // inc (hl)
+	storeB(HL, loadB(HL) + 1);
+	set_inc_flags(loadB(HL));
+)
+Z80_OP_MAIN(0x35, // dec (hl)
+	storeB(HL, loadB(HL) - 1);
+	set_dec_flags(loadB(HL));
+)
+Z80_OP_MAIN(0x36, // ld (hl),d8
+	storeB(HL, loadB());
+)
+Z80_OP_MAIN(0x37, // scf
+	F() |= FLAG_C;
+	F() &= ~FLAG_N & ~FLAG_H;
+)
+Z80_OP_MAIN(0x38, // jr c,s8
+	jr_if(F() & FLAG_C);
+)
+Z80_OP_MAIN(0x39, // add hl,sp
+	addHL(SP);
+)
+Z80_OP_MAIN(0x3A, // ld a,(a16)
+	A() = loadB(loadW());
+)
+Z80_OP_MAIN(0x3B, // dec sp
+	--SP;
+)
+Z80_OP_MAIN(0x3C, // inc a
+	set_inc_flags(++A());
+)
+Z80_OP_MAIN(0x3D, // dec a
+	set_dec_flags(--A());
+)
+Z80_OP_MAIN(0x3E, // ld a,d8
+	A() = loadB();
+)
+Z80_OP_MAIN(0x3F, // ccf
+	F() = (F() & FLAG_C) ? ((F() & ~FLAG_C) | FLAG_H) : ((F() | FLAG_C) & ~FLAG_H);
+	F() &= ~FLAG_N;
+)
+Z80_OP_MAIN(0x40, // ld b,b
+	B() = B();
+)
+Z80_OP_MAIN(0x41, // ld b,c
+	B() = C();
+)
+Z80_OP_MAIN(0x42, // ld b,d
+	B() = D();
+)
+Z80_OP_MAIN(0x43, // ld b,e
+	B() = E();
+)
+Z80_OP_MAIN(0x44, // ld b,h
+	B() = H();
+)
+Z80_OP_MAIN(0x45, // ld b,l
+	B() = L();
+)
+Z80_OP_MAIN(0x46, // ld b,(hl)
+	B() = loadB(HL);
+)
+Z80_OP_MAIN(0x47, // ld b,a
+	B() = A();
+)
+Z80_OP_MAIN(0x48, // ld c,b
+	C() = B();
+)
+Z80_OP_MAIN(0x49, // ld c,c
+	C() = C();
+)
+Z80_OP_MAIN(0x4A, // ld c,d
+	C() = D();
+)
+Z80_OP_MAIN(0x4B, // ld c,e
+	C() = E();
+)
+Z80_OP_MAIN(0x4C, // ld c,h
+	C() = H();
+)
+Z80_OP_MAIN(0x4D, // ld c,l
+	C() = L();
+)
+Z80_OP_MAIN(0x4E, // ld c,(hl)
+	C() = loadB(HL);
+)
+Z80_OP_MAIN(0x4F, // ld c,a
+	C() = A();
+)
+Z80_OP_MAIN(0x50, // ld d,b
+	D() = B();
+)
+Z80_OP_MAIN(0x51, // ld d,c
+	D() = C();
+)
+Z80_OP_MAIN(0x52, // ld d,d
+	D() = D();
+)
+Z80_OP_MAIN(0x53, // ld d,e
+	D() = E();
+)
+Z80_OP_MAIN(0x54, // ld d,h
+	D() = H();
+)
+Z80_OP_MAIN(0x55, // ld d,l
+	D() = L();
+)
+Z80_OP_MAIN(0x56, // ld d,(hl)
+	D() = loadB(HL);
+)
+Z80_OP_MAIN(0x57, // ld d,a
+	D() = A();
+)
+Z80_OP_MAIN(0x58, // ld e,b
+	E() = B();
+)
+Z80_OP_MAIN(0x59, // ld e,c
+	E() = C();
+)
+Z80_OP_MAIN(0x5A, // ld e,d
+	E() = D();
+)
+Z80_OP_MAIN(0x5B, // ld e,e
+	E() = E();
+)
+Z80_OP_MAIN(0x5C, // ld e,h
+	E() = H();
+)
+Z80_OP_MAIN(0x5D, // ld e,l
+	E() = L();
+)
+Z80_OP_MAIN(0x5E, // ld e,(hl)
+	E() = loadB(HL);
+)
+Z80_OP_MAIN(0x5F, // ld e,a
+	E() = A();
+)
+Z80_OP_MAIN(0x60, // ld h,b
+	H() = B();
+)
+Z80_OP_MAIN(0x61, // ld h,c
+	H() = C();
+)
+Z80_OP_MAIN(0x62, // ld h,d
+	H() = D();
+)
+Z80_OP_MAIN(0x63, // ld h,e
+	H() = E();
+)
+Z80_OP_MAIN(0x64, // ld h,h
+	H() = H();
+)
+Z80_OP_MAIN(0x65, // ld h,l
+	H() = L();
+)
+Z80_OP_MAIN(0x66, // ld h,(hl)
+	H() = loadB(HL);
+)
+Z80_OP_MAIN(0x67, // ld h,a
+	H() = A();
+)
+Z80_OP_MAIN(0x68, // ld l,b
+	L() = B();
+)
+Z80_OP_MAIN(0x69, // ld l,c
+	L() = C();
+)
+Z80_OP_MAIN(0x6A, // ld l,d
+	L() = D();
+)
+Z80_OP_MAIN(0x6B, // ld l,e
+	L() = E();
+)
+Z80_OP_MAIN(0x6C, // ld l,h
+	L() = H();
+)
+Z80_OP_MAIN(0x6D, // ld l,l
+	L() = L();
+)
+Z80_OP_MAIN(0x6E, // ld l,(hl)
+	L() = loadB(HL);
+)
+Z80_OP_MAIN(0x6F, // ld l,a
+	L() = A();
+)
+Z80_OP_MAIN(0x70, // ld (hl),b
+	storeB(HL, B());
+)
+Z80_OP_MAIN(0x71, // ld (hl),c
+	storeB(HL, C());
+)
+Z80_OP_MAIN(0x72, // ld (hl),d
+	storeB(HL, D());
+)
+Z80_OP_MAIN(0x73, // ld (hl),e
+	storeB(HL, E());
+)
+Z80_OP_MAIN(0x74, // ld (hl),h
+	storeB(HL, H());
+)
+Z80_OP_MAIN(0x75, // ld (hl),l
+	storeB(HL, L());
+)
+Z80_OP_MAIN(0x76, // halt
+	halted_ = true;
+)
+Z80_OP_MAIN(0x77, // ld (hl),a
+	storeB(HL, A());
+)
+Z80_OP_MAIN(0x78, // ld a,b
+	A() = B();
+)
+Z80_OP_MAIN(0x79, // ld a,c
+	A() = C();
+)
+Z80_OP_MAIN(0x7A, // ld a,d
+	A() = D();
+)
+Z80_OP_MAIN(0x7B, // ld a,e
+	A() = E();
+)
+Z80_OP_MAIN(0x7C, // ld a,h
+	A() = H();
+)
+Z80_OP_MAIN(0x7D, // ld a,l
+	A() = L();
+)
+Z80_OP_MAIN(0x7E, // ld a,(hl)
+	A() = loadB(HL);
+)
+Z80_OP_MAIN(0x7F, // ld a,a
+	A() = A();
+)
+Z80_OP_MAIN(0x80, // add a,b
+	addA(B());
+)
+Z80_OP_MAIN(0x81, // add a,c
+	addA(C());
+)
+Z80_OP_MAIN(0x82, // add a,d
+	addA(D());
+)
+Z80_OP_MAIN(0x83, // add a,e
+	addA(E());
+)
+Z80_OP_MAIN(0x84, // add a,h
+	addA(H());
+)
+Z80_OP_MAIN(0x85, // add a,l
+	addA(L());
+)
+Z80_OP_MAIN(0x86, // add a,(hl)
+	addA(loadB(HL));
+)
+Z80_OP_MAIN(0x87, // add a,a
+	addA(A());
+)
+Z80_OP_MAIN(0x88, // adc a,b
+	addA(B(), true);
+)
+Z80_OP_MAIN(0x89, // adc a,c
+	addA(C(), true);
+)
+Z80_OP_MAIN(0x8A, // adc a,d
+	addA(D(), true);
+)
+Z80_OP_MAIN(0x8B, // adc a,e
+	addA(E(), true);
+)
+Z80_OP_MAIN(0x8C, // adc a,h
+	addA(H(), true);
+)
+Z80_OP_MAIN(0x8D, // adc a,l
+	addA(L(), true);
+)
+Z80_OP_MAIN(0x8E, // adc a,(hl)
+	addA(loadB(HL), true);
+)
+Z80_OP_MAIN(0x8F, // adc a,a
+	addA(A(), true);
+)
+Z80_OP_MAIN(0x90, // sub b
+	subA(B());
+)
+Z80_OP_MAIN(0x91, // sub c
+	subA(C());
+)
+Z80_OP_MAIN(0x92, // sub d
+	subA(D());
+)
+Z80_OP_MAIN(0x93, // sub e
+	subA(E());
+)
+Z80_OP_MAIN(0x94, // sub h
+	subA(H());
+)
+Z80_OP_MAIN(0x95, // sub l
+	subA(L());
+)
+Z80_OP_MAIN(0x96, // sub (hl)
+	subA(loadB(HL));
+)
+Z80_OP_MAIN(0x97, // sub a
+	subA(A());
+)
+Z80_OP_MAIN(0x98, // sbc a,b
+	subA(B(), true);
+)
+Z80_OP_MAIN(0x99, // sbc a,c
+	subA(C(), true);
+)
+Z80_OP_MAIN(0x9A, // sbc a,d
+	subA(D(), true);
+)
+Z80_OP_MAIN(0x9B, // sbc a,e
+	subA(E(), true);
+)
+Z80_OP_MAIN(0x9C, // sbc a,h
+	subA(H(), true);
+)
+Z80_OP_MAIN(0x9D, // sbc a,l
+	subA(L(), true);
+)
+Z80_OP_MAIN(0x9E, // sbc a,(hl)
+	subA(loadB(HL), true);
+)
+Z80_OP_MAIN(0x9F, // sbc a,a
+	subA(A(), true);
+)
+Z80_OP_MAIN(0xA0, // and b
+	logicA(A() & B(), true);
+)
+Z80_OP_MAIN(0xA1, // and c
+	logicA(A() & C(), true);
+)
+Z80_OP_MAIN(0xA2, // and d
+	logicA(A() & D(), true);
+)
+Z80_OP_MAIN(0xA3, // and e
+	logicA(A() & E(), true);
+)
+Z80_OP_MAIN(0xA4, // and h
+	logicA(A() & H(), true);
+)
+Z80_OP_MAIN(0xA5, // and l
+	logicA(A() & L(), true);
+)
+Z80_OP_MAIN(0xA6, // and (hl)
+	logicA(A() & loadB(HL), true);
+)
+Z80_OP_MAIN(0xA7, // and a
+	logicA(A() & A(), true);
+)
+Z80_OP_MAIN(0xA8, // xor b
+	logicA(A() ^ B(), false);
+)
+Z80_OP_MAIN(0xA9, // xor c
+	logicA(A() ^ C(), false);
+)
+Z80_OP_MAIN(0xAA, // xor d
+	logicA(A() ^ D(), false);
+)
+Z80_OP_MAIN(0xAB, // xor e
+	logicA(A() ^ E(), false);
+)
+Z80_OP_MAIN(0xAC, // xor h
+	logicA(A() ^ H(), false);
+)
+Z80_OP_MAIN(0xAD, // xor l
+	logicA(A() ^ L(), false);
+)
+Z80_OP_MAIN(0xAE, // xor (hl)
+	logicA(A() ^ loadB(HL), false);
+)
+Z80_OP_MAIN(0xAF, // xor a
+	logicA(A() ^ A(), false);
+)
+Z80_OP_MAIN(0xB0, // or b
+	logicA(A() | B(), false);
+)
+Z80_OP_MAIN(0xB1, // or c
+	logicA(A() | C(), false);
+)
+Z80_OP_MAIN(0xB2, // or d
+	logicA(A() | D(), false);
+)
+Z80_OP_MAIN(0xB3, // or e
+	logicA(A() | E(), false);
+)
+Z80_OP_MAIN(0xB4, // or h
+	logicA(A() | H(), false);
+)
+Z80_OP_MAIN(0xB5, // or l
+	logicA(A() | L(), false);
+)
+Z80_OP_MAIN(0xB6, // or (hl)
+	logicA(A() | loadB(HL), false);
+)
+Z80_OP_MAIN(0xB7, // or a
+	logicA(A() | A(), false);
+)
+Z80_OP_MAIN(0xB8, // cp b
+	t8 = A();
+	subA(B());
+	A() = t8;
+)
+Z80_OP_MAIN(0xB9, // cp c
+	t8 = A();
+	subA(C());
+	A() = t8;
+)
+Z80_OP_MAIN(0xBA, // cp d
+	t8 = A();
+	subA(D());
+	A() = t8;
+)
+Z80_OP_MAIN(0xBB, // cp e
+	t8 = A();
+	subA(E());
+	A() = t8;
+)
+Z80_OP_MAIN(0xBC, // cp h
+	t8 = A();
+	subA(H());
+	A() = t8;
+)
+Z80_OP_MAIN(0xBD, // cp l
+	t8 = A();
+	subA(L());
+	A() = t8;
+)
+Z80_OP_MAIN(0xBE, // cp (hl)
+	t8 = A();
+	subA(loadB(HL));
+	A() = t8;
+)
+Z80_OP_MAIN(0xBF, // cp a
+	t8 = A();
+	subA(A());
+	A() = t8;
+)
+Z80_OP_MAIN(0xC0, // ret nz
+	ret_if(!(F() & FLAG_Z));
+)
+Z80_OP_MAIN(0xC1, // pop bc
+	BC = popW();
+)
+Z80_OP_MAIN(0xC2, // jp nz,a16
+	t16 = loadW();
+	if(!(F() & FLAG_Z)) PC = t16;
+)
+Z80_OP_MAIN(0xC3, // jp a16
+	PC = loadW();
+)
+Z80_OP_MAIN(0xC4, // call nz,a16
+	t16 = loadW();
+	call_if(!(F() & FLAG_Z), t16);
+)
+Z80_OP_MAIN(0xC5, // push bc
+	pushW(BC);
+)
+Z80_OP_MAIN(0xC6, // add a,d8
+	addA(loadB());
+)
+Z80_OP_MAIN(0xC7, // rst 00h
+	call(0x0000);
+)
+Z80_OP_MAIN(0xC8, // ret z
+	ret_if(F() & FLAG_Z);
+)
+Z80_OP_MAIN(0xC9, // ret
+	ret();
+)
+Z80_OP_MAIN(0xCA, // jp z,a16
+	t16 = loadW();
+	if(F() & FLAG_Z) PC = t16;
+)
+Z80_OP_MAIN(0xCC, // call z,a16
+	t16 = loadW();
+	call_if(F() & FLAG_Z, t16);
+)
+Z80_OP_MAIN(0xCD, // call a16
+	call(loadW());
+)
+Z80_OP_MAIN(0xCE, // adc a,d8
+	addA(loadB(), true);
+)
+Z80_OP_MAIN(0xCF, // rst 08h
+	call(0x0008);
+)
+Z80_OP_MAIN(0xD0, // ret nc
+	ret_if(!(F() & FLAG_C));
+)
+Z80_OP_MAIN(0xD1, // pop de
+	DE = popW();
+)
+Z80_OP_MAIN(0xD2, // jp nc,a16
+	t16 = loadW();
+	if(!(F() & FLAG_C)) PC = t16;
+)
+Z80_OP_MAIN(0xD3, // out (d8),a
+	out(loadB(), A());
+)
+Z80_OP_MAIN(0xD4, // call nc,a16
+	t16 = loadW();
+	call_if(!(F() & FLAG_C), t16);
+)
+Z80_OP_MAIN(0xD5, // push de
+	pushW(DE);
+)
+Z80_OP_MAIN(0xD6, // sub d8
+	subA(loadB());
+)
+Z80_OP_MAIN(0xD7, // rst 10h
+	call(0x0010);
+)
+Z80_OP_MAIN(0xD8, // ret c
+	ret_if(F() & FLAG_C);
+)
+Z80_OP_MAIN(0xD9, // exx
+	swap(BC, BCp);
+	swap(DE, DEp);
+	swap(HL, HLp);
+)
+Z80_OP_MAIN(0xDA, // jp c,a16
+	t16 = loadW();
+	if(F() & FLAG_C) PC = t16;
+)
+Z80_OP_MAIN(0xDB, // in a,(d8)
+	A() = in(loadB());
+)
+Z80_OP_MAIN(0xDC, // call c,a16
+	t16 = loadW();
+	call_if(F() & FLAG_C, t16);
+)
+Z80_OP_MAIN(0xDE, // sbc a,d8
+	subA(loadB(), true);
+)
+Z80_OP_MAIN(0xDF, // rst 18h
+	call(0x0018);
+)
+Z80_OP_MAIN(0xE0, // ret po
+	ret_if(!(F() & FLAG_PV));
+)
+Z80_OP_MAIN(0xE1, // pop hl
+	HL = popW();
+)
+Z80_OP_MAIN(0xE2, // jp po,a16
+	t16 = loadW();
+	if(!(F() & FLAG_PV)) PC = t16;
+)
+Z80_OP_MAIN(0xE3, // ex (sp),hl
+	t16 = loadW(SP);
+	storeW(SP, HL);
+	HL = t16;
+)
+Z80_OP_MAIN(0xE4, // call po,a16
+	t16 = loadW();
+	call_if(!(F() & FLAG_PV), t16);
+)
+Z80_OP_MAIN(0xE5, // push hl
+	pushW(HL);
+)
+Z80_OP_MAIN(0xE6, // and d8
+	logicA(A() & loadB(), true);
+)
+Z80_OP_MAIN(0xE7, // rst 20h
+	call(0x0020);
+)
+Z80_OP_MAIN(0xE8, // ret pe
+	ret_if(F() & FLAG_PV);
+)
+Z80_OP_MAIN(0xE9, // jp (hl)
+	PC = HL;
+)
+Z80_OP_MAIN(0xEA, // jp pe,a16
+	t16 = loadW();
+	if(F() & FLAG_PV) PC = t16;
+)
+Z80_OP_MAIN(0xEB, // ex de,hl
+	swap(DE, HL);
+)
+Z80_OP_MAIN(0xEC, // call pe,a16
+	t16 = loadW();
+	call_if(F() & FLAG_PV, t16);
+)
+Z80_OP_MAIN(0xEE, // xor d8
+	logicA(A() ^ loadB(), false);
+)
+Z80_OP_MAIN(0xEF, // rst 28h
+	call(0x0028);
+)
+Z80_OP_MAIN(0xF0, // ret p
+	ret_if(!(F() & FLAG_N));
+)
+Z80_OP_MAIN(0xF1, // pop af
+	AF = popW();
+)
+Z80_OP_MAIN(0xF2, // jp p,a16
+	t16 = loadW();
+	if(!(F() & FLAG_N)) PC = t16;
+)
+Z80_OP_MAIN(0xF3, // di
+	int_ = false;
+)
+Z80_OP_MAIN(0xF4, // call p,a16
+	t16 = loadW();
+	call_if(!(F() & FLAG_N), t16);
+)
+Z80_OP_MAIN(0xF5, // push af
+	pushW(AF);
+)
+Z80_OP_MAIN(0xF6, // or d8
+	logicA(A() | loadB(), false);
+)
+Z80_OP_MAIN(0xF7, // rst 30h
+	call(0x0030);
+)
+Z80_OP_MAIN(0xF8, // ret m
+	ret_if(F() & FLAG_N);
+)
+Z80_OP_MAIN(0xF9, // ld sp,hl
+	SP = HL;
+)
+Z80_OP_MAIN(0xFA, // jp m,a16
+	t16 = loadW();
+	if(F() & FLAG_N) PC = t16;
+)
+Z80_OP_MAIN(0xFB, // ei
+	int_ = true;
+)
+Z80_OP_MAIN(0xFC, // call m,a16
+	t16 = loadW();
+	call_if(F() & FLAG_N, t16);
+)
+Z80_OP_MAIN(0xFE, // cp d8
+	t8 = A();
+	subA(loadB());
+	A() = t8;
+)
+Z80_OP_MAIN(0xFF, // rst 38h
+	call(0x0038);
+)
+
+// # --------------------------------------------------------------------------- 
+// # 0xCB
+
+Z80_OP_CB(0x00, // rlc b
+	rotate_left(B(), BIT_BIT7);
+)
+Z80_OP_CB(0x01, // rlc c
+	rotate_left(C(), BIT_BIT7);
+)
+Z80_OP_CB(0x02, // rlc d
+	rotate_left(D(), BIT_BIT7);
+)
+Z80_OP_CB(0x03, // rlc e
+	rotate_left(E(), BIT_BIT7);
+)
+Z80_OP_CB(0x04, // rlc h
+	rotate_left(H(), BIT_BIT7);
+)
+Z80_OP_CB(0x05, // rlc l
+	rotate_left(L(), BIT_BIT7);
+)
+Z80_OP_CB(0x06, // rlc (hl)
+	t8 = loadB(HL);
+	rotate_left(t8, BIT_BIT7);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x07, // rlc a
+	rotate_left(B(), BIT_BIT7);
+)
+Z80_OP_CB(0x08, // rrc b
+	rotate_right(B(), BIT_BIT7);
+)
+Z80_OP_CB(0x09, // rrc c
+	rotate_right(C(), BIT_BIT7);
+)
+Z80_OP_CB(0x0A, // rrc d
+	rotate_right(D(), BIT_BIT7);
+)
+Z80_OP_CB(0x0B, // rrc e
+	rotate_right(E(), BIT_BIT7);
+)
+Z80_OP_CB(0x0C, // rrc h
+	rotate_right(H(), BIT_BIT7);
+)
+Z80_OP_CB(0x0D, // rrc l
+	rotate_right(L(), BIT_BIT7);
+)
+Z80_OP_CB(0x0E, // rrc (hl)
+	t8 = loadB(HL);
+	rotate_right(t8, BIT_BIT7);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x0F, // rrc a
+	rotate_right(B(), BIT_BIT7);
+)
+Z80_OP_CB(0x10, // rl b
+	rotate_left(B(), BIT_CARRY);
+)
+Z80_OP_CB(0x11, // rl c
+	rotate_left(C(), BIT_CARRY);
+)
+Z80_OP_CB(0x12, // rl d
+	rotate_left(D(), BIT_CARRY);
+)
+Z80_OP_CB(0x13, // rl e
+	rotate_left(E(), BIT_CARRY);
+)
+Z80_OP_CB(0x14, // rl h
+	rotate_left(H(), BIT_CARRY);
+)
+Z80_OP_CB(0x15, // rl l
+	rotate_left(L(), BIT_CARRY);
+)
+Z80_OP_CB(0x16, // rl (hl)
+	t8 = loadB(HL);
+	rotate_left(t8, BIT_CARRY);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x17, // rl a
+	rotate_left(B(), BIT_CARRY);
+)
+Z80_OP_CB(0x18, // rr b
+	rotate_right(B(), BIT_CARRY);
+)
+Z80_OP_CB(0x19, // rr c
+	rotate_right(C(), BIT_CARRY);
+)
+Z80_OP_CB(0x1A, // rr d
+	rotate_right(D(), BIT_CARRY);
+)
+Z80_OP_CB(0x1B, // rr e
+	rotate_right(E(), BIT_CARRY);
+)
+Z80_OP_CB(0x1C, // rr h
+	rotate_right(H(), BIT_CARRY);
+)
+Z80_OP_CB(0x1D, // rr l
+	rotate_right(L(), BIT_CARRY);
+)
+Z80_OP_CB(0x1E, // rr (hl)
+	t8 = loadB(HL);
+	rotate_right(t8, BIT_CARRY);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x1F, // rr a
+	rotate_right(B(), BIT_CARRY);
+)
+Z80_OP_CB(0x20, // sla b
+	rotate_left(B(), BIT_A);
+)
+Z80_OP_CB(0x21, // sla c
+	rotate_left(C(), BIT_A);
+)
+Z80_OP_CB(0x22, // sla d
+	rotate_left(D(), BIT_A);
+)
+Z80_OP_CB(0x23, // sla e
+	rotate_left(E(), BIT_A);
+)
+Z80_OP_CB(0x24, // sla h
+	rotate_left(H(), BIT_A);
+)
+Z80_OP_CB(0x25, // sla l
+	rotate_left(L(), BIT_A);
+)
+Z80_OP_CB(0x26, // sla (hl)
+	t8 = loadB(HL);
+	rotate_left(t8, BIT_A);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x27, // sla a
+	rotate_left(B(), BIT_A);
+)
+Z80_OP_CB(0x28, // sra b
+	rotate_right(B(), BIT_A);
+)
+Z80_OP_CB(0x29, // sra c
+	rotate_right(C(), BIT_A);
+)
+Z80_OP_CB(0x2A, // sra d
+	rotate_right(D(), BIT_A);
+)
+Z80_OP_CB(0x2B, // sra e
+	rotate_right(E(), BIT_A);
+)
+Z80_OP_CB(0x2C, // sra h
+	rotate_right(H(), BIT_A);
+)
+Z80_OP_CB(0x2D, // sra l
+	rotate_right(L(), BIT_A);
+)
+Z80_OP_CB(0x2E, // sra (hl)
+	t8 = loadB(HL);
+	rotate_right(t8, BIT_A);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x2F, // sra a
+	rotate_right(B(), BIT_A);
+)
+Z80_OP_CB(0x30, // sll b
+	rotate_left(B(), BIT_L);
+)
+Z80_OP_CB(0x31, // sll c
+	rotate_left(C(), BIT_L);
+)
+Z80_OP_CB(0x32, // sll d
+	rotate_left(D(), BIT_L);
+)
+Z80_OP_CB(0x33, // sll e
+	rotate_left(E(), BIT_L);
+)
+Z80_OP_CB(0x34, // sll h
+	rotate_left(H(), BIT_L);
+)
+Z80_OP_CB(0x35, // sll l
+	rotate_left(L(), BIT_L);
+)
+Z80_OP_CB(0x36, // sll (hl)
+	t8 = loadB(HL);
+	rotate_left(t8, BIT_L);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x37, // sll a
+	rotate_left(B(), BIT_L);
+)
+Z80_OP_CB(0x38, // srl b
+	rotate_right(B(), BIT_L);
+)
+Z80_OP_CB(0x39, // srl c
+	rotate_right(C(), BIT_L);
+)
+Z80_OP_CB(0x3A, // srl d
+	rotate_right(D(), BIT_L);
+)
+Z80_OP_CB(0x3B, // srl e
+	rotate_right(E(), BIT_L);
+)
+Z80_OP_CB(0x3C, // srl h
+	rotate_right(H(), BIT_L);
+)
+Z80_OP_CB(0x3D, // srl l
+	rotate_right(L(), BIT_L);
+)
+Z80_OP_CB(0x3E, // srl (hl)
+	t8 = loadB(HL);
+	rotate_right(t8, BIT_L);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x3F, // srl a
+	rotate_right(B(), BIT_L);
+)
+Z80_OP_CB(0x40, // bit 0,b
+	test_bit(B(), 0);
+)
+Z80_OP_CB(0x41, // bit 0,c
+	test_bit(C(), 0);
+)
+Z80_OP_CB(0x42, // bit 0,d
+	test_bit(D(), 0);
+)
+Z80_OP_CB(0x43, // bit 0,e
+	test_bit(E(), 0);
+)
+Z80_OP_CB(0x44, // bit 0,h
+	test_bit(H(), 0);
+)
+Z80_OP_CB(0x45, // bit 0,l
+	test_bit(L(), 0);
+)
+Z80_OP_CB(0x46, // bit 0,(hl)
+	test_bit(loadB(HL), 0);
+)
+Z80_OP_CB(0x47, // bit 0,a
+	test_bit(A(), 0);
+)
+Z80_OP_CB(0x48, // bit 1,b
+	test_bit(B(), 1);
+)
+Z80_OP_CB(0x49, // bit 1,c
+	test_bit(C(), 1);
+)
+Z80_OP_CB(0x4A, // bit 1,d
+	test_bit(D(), 1);
+)
+Z80_OP_CB(0x4B, // bit 1,e
+	test_bit(E(), 1);
+)
+Z80_OP_CB(0x4C, // bit 1,h
+	test_bit(H(), 1);
+)
+Z80_OP_CB(0x4D, // bit 1,l
+	test_bit(L(), 1);
+)
+Z80_OP_CB(0x4E, // bit 1,(hl)
+	test_bit(loadB(HL), 1);
+)
+Z80_OP_CB(0x4F, // bit 1,a
+	test_bit(A(), 1);
+)
+Z80_OP_CB(0x50, // bit 2,b
+	test_bit(B(), 2);
+)
+Z80_OP_CB(0x51, // bit 2,c
+	test_bit(C(), 2);
+)
+Z80_OP_CB(0x52, // bit 2,d
+	test_bit(D(), 2);
+)
+Z80_OP_CB(0x53, // bit 2,e
+	test_bit(E(), 2);
+)
+Z80_OP_CB(0x54, // bit 2,h
+	test_bit(H(), 2);
+)
+Z80_OP_CB(0x55, // bit 2,l
+	test_bit(L(), 2);
+)
+Z80_OP_CB(0x56, // bit 2,(hl)
+	test_bit(loadB(HL), 2);
+)
+Z80_OP_CB(0x57, // bit 2,a
+	test_bit(A(), 2);
+)
+Z80_OP_CB(0x58, // bit 3,b
+	test_bit(B(), 3);
+)
+Z80_OP_CB(0x59, // bit 3,c
+	test_bit(C(), 3);
+)
+Z80_OP_CB(0x5A, // bit 3,d
+	test_bit(D(), 3);
+)
+Z80_OP_CB(0x5B, // bit 3,e
+	test_bit(E(), 3);
+)
+Z80_OP_CB(0x5C, // bit 3,h
+	test_bit(H(), 3);
+)
+Z80_OP_CB(0x5D, // bit 3,l
+	test_bit(L(), 3);
+)
+Z80_OP_CB(0x5E, // bit 3,(hl)
+	test_bit(loadB(HL), 3);
+)
+Z80_OP_CB(0x5F, // bit 3,a
+	test_bit(A(), 3);
+)
+Z80_OP_CB(0x60, // bit 4,b
+	test_bit(B(), 4);
+)
+Z80_OP_CB(0x61, // bit 4,c
+	test_bit(C(), 4);
+)
+Z80_OP_CB(0x62, // bit 4,d
+	test_bit(D(), 4);
+)
+Z80_OP_CB(0x63, // bit 4,e
+	test_bit(E(), 4);
+)
+Z80_OP_CB(0x64, // bit 4,h
+	test_bit(H(), 4);
+)
+Z80_OP_CB(0x65, // bit 4,l
+	test_bit(L(), 4);
+)
+Z80_OP_CB(0x66, // bit 4,(hl)
+	test_bit(loadB(HL), 4);
+)
+Z80_OP_CB(0x67, // bit 4,a
+	test_bit(A(), 4);
+)
+Z80_OP_CB(0x68, // bit 5,b
+	test_bit(B(), 5);
+)
+Z80_OP_CB(0x69, // bit 5,c
+	test_bit(C(), 5);
+)
+Z80_OP_CB(0x6A, // bit 5,d
+	test_bit(D(), 5);
+)
+Z80_OP_CB(0x6B, // bit 5,e
+	test_bit(E(), 5);
+)
+Z80_OP_CB(0x6C, // bit 5,h
+	test_bit(H(), 5);
+)
+Z80_OP_CB(0x6D, // bit 5,l
+	test_bit(L(), 5);
+)
+Z80_OP_CB(0x6E, // bit 5,(hl)
+	test_bit(loadB(HL), 5);
+)
+Z80_OP_CB(0x6F, // bit 5,a
+	test_bit(A(), 5);
+)
+Z80_OP_CB(0x70, // bit 6,b
+	test_bit(B(), 6);
+)
+Z80_OP_CB(0x71, // bit 6,c
+	test_bit(C(), 6);
+)
+Z80_OP_CB(0x72, // bit 6,d
+	test_bit(D(), 6);
+)
+Z80_OP_CB(0x73, // bit 6,e
+	test_bit(E(), 6);
+)
+Z80_OP_CB(0x74, // bit 6,h
+	test_bit(H(), 6);
+)
+Z80_OP_CB(0x75, // bit 6,l
+	test_bit(L(), 6);
+)
+Z80_OP_CB(0x76, // bit 6,(hl)
+	test_bit(loadB(HL), 6);
+)
+Z80_OP_CB(0x77, // bit 6,a
+	test_bit(A(), 6);
+)
+Z80_OP_CB(0x78, // bit 7,b
+	test_bit(B(), 7);
+)
+Z80_OP_CB(0x79, // bit 7,c
+	test_bit(C(), 7);
+)
+Z80_OP_CB(0x7A, // bit 7,d
+	test_bit(D(), 7);
+)
+Z80_OP_CB(0x7B, // bit 7,e
+	test_bit(E(), 7);
+)
+Z80_OP_CB(0x7C, // bit 7,h
+	test_bit(H(), 7);
+)
+Z80_OP_CB(0x7D, // bit 7,l
+	test_bit(L(), 7);
+)
+Z80_OP_CB(0x7E, // bit 7,(hl)
+	test_bit(loadB(HL), 7);
+)
+Z80_OP_CB(0x7F, // bit 7,a
+	test_bit(A(), 7);
+)
+Z80_OP_CB(0x80, // res 0,b
+	B() &= ~(1 << 0);
+)
+Z80_OP_CB(0x81, // res 0,c
+	C() &= ~(1 << 0);
+)
+Z80_OP_CB(0x82, // res 0,d
+	D() &= ~(1 << 0);
+)
+Z80_OP_CB(0x83, // res 0,e
+	E() &= ~(1 << 0);
+)
+Z80_OP_CB(0x84, // res 0,h
+	H() &= ~(1 << 0);
+)
+Z80_OP_CB(0x85, // res 0,l
+	L() &= ~(1 << 0);
+)
+Z80_OP_CB(0x86, // res 0,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 0);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x87, // res 0,a
+	A() &= ~(1 << 0);
+)
+Z80_OP_CB(0x88, // res 1,b
+	B() &= ~(1 << 1);
+)
+Z80_OP_CB(0x89, // res 1,c
+	C() &= ~(1 << 1);
+)
+Z80_OP_CB(0x8A, // res 1,d
+	D() &= ~(1 << 1);
+)
+Z80_OP_CB(0x8B, // res 1,e
+	E() &= ~(1 << 1);
+)
+Z80_OP_CB(0x8C, // res 1,h
+	H() &= ~(1 << 1);
+)
+Z80_OP_CB(0x8D, // res 1,l
+	L() &= ~(1 << 1);
+)
+Z80_OP_CB(0x8E, // res 1,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 1);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x8F, // res 1,a
+	A() &= ~(1 << 1);
+)
+Z80_OP_CB(0x90, // res 2,b
+	B() &= ~(1 << 2);
+)
+Z80_OP_CB(0x91, // res 2,c
+	C() &= ~(1 << 2);
+)
+Z80_OP_CB(0x92, // res 2,d
+	D() &= ~(1 << 2);
+)
+Z80_OP_CB(0x93, // res 2,e
+	E() &= ~(1 << 2);
+)
+Z80_OP_CB(0x94, // res 2,h
+	H() &= ~(1 << 2);
+)
+Z80_OP_CB(0x95, // res 2,l
+	L() &= ~(1 << 2);
+)
+Z80_OP_CB(0x96, // res 2,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 2);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x97, // res 2,a
+	A() &= ~(1 << 2);
+)
+Z80_OP_CB(0x98, // res 3,b
+	B() &= ~(1 << 3);
+)
+Z80_OP_CB(0x99, // res 3,c
+	C() &= ~(1 << 3);
+)
+Z80_OP_CB(0x9A, // res 3,d
+	D() &= ~(1 << 3);
+)
+Z80_OP_CB(0x9B, // res 3,e
+	E() &= ~(1 << 3);
+)
+Z80_OP_CB(0x9C, // res 3,h
+	H() &= ~(1 << 3);
+)
+Z80_OP_CB(0x9D, // res 3,l
+	L() &= ~(1 << 3);
+)
+Z80_OP_CB(0x9E, // res 3,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 3);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0x9F, // res 3,a
+	A() &= ~(1 << 3);
+)
+Z80_OP_CB(0xA0, // res 4,b
+	B() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA1, // res 4,c
+	C() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA2, // res 4,d
+	D() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA3, // res 4,e
+	E() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA4, // res 4,h
+	H() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA5, // res 4,l
+	L() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA6, // res 4,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 4);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xA7, // res 4,a
+	A() &= ~(1 << 4);
+)
+Z80_OP_CB(0xA8, // res 5,b
+	B() &= ~(1 << 5);
+)
+Z80_OP_CB(0xA9, // res 5,c
+	C() &= ~(1 << 5);
+)
+Z80_OP_CB(0xAA, // res 5,d
+	D() &= ~(1 << 5);
+)
+Z80_OP_CB(0xAB, // res 5,e
+	E() &= ~(1 << 5);
+)
+Z80_OP_CB(0xAC, // res 5,h
+	H() &= ~(1 << 5);
+)
+Z80_OP_CB(0xAD, // res 5,l
+	L() &= ~(1 << 5);
+)
+Z80_OP_CB(0xAE, // res 5,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 5);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xAF, // res 5,a
+	A() &= ~(1 << 5);
+)
+Z80_OP_CB(0xB0, // res 6,b
+	B() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB1, // res 6,c
+	C() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB2, // res 6,d
+	D() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB3, // res 6,e
+	E() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB4, // res 6,h
+	H() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB5, // res 6,l
+	L() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB6, // res 6,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 6);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xB7, // res 6,a
+	A() &= ~(1 << 6);
+)
+Z80_OP_CB(0xB8, // res 7,b
+	B() &= ~(1 << 7);
+)
+Z80_OP_CB(0xB9, // res 7,c
+	C() &= ~(1 << 7);
+)
+Z80_OP_CB(0xBA, // res 7,d
+	D() &= ~(1 << 7);
+)
+Z80_OP_CB(0xBB, // res 7,e
+	E() &= ~(1 << 7);
+)
+Z80_OP_CB(0xBC, // res 7,h
+	H() &= ~(1 << 7);
+)
+Z80_OP_CB(0xBD, // res 7,l
+	L() &= ~(1 << 7);
+)
+Z80_OP_CB(0xBE, // res 7,(hl)
+	t8 = loadB(HL);
+	t8 &= ~(1 << 7);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xBF, // res 7,a
+	A() &= ~(1 << 7);
+)
+Z80_OP_CB(0xC0, // set 0,b
+	B() |=  (1 << 0);
+)
+Z80_OP_CB(0xC1, // set 0,c
+	C() |=  (1 << 0);
+)
+Z80_OP_CB(0xC2, // set 0,d
+	D() |=  (1 << 0);
+)
+Z80_OP_CB(0xC3, // set 0,e
+	E() |=  (1 << 0);
+)
+Z80_OP_CB(0xC4, // set 0,h
+	H() |=  (1 << 0);
+)
+Z80_OP_CB(0xC5, // set 0,l
+	L() |=  (1 << 0);
+)
+Z80_OP_CB(0xC6, // set 0,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 0);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xC7, // set 0,a
+	A() |=  (1 << 0);
+)
+Z80_OP_CB(0xC8, // set 1,b
+	B() |=  (1 << 1);
+)
+Z80_OP_CB(0xC9, // set 1,c
+	C() |=  (1 << 1);
+)
+Z80_OP_CB(0xCA, // set 1,d
+	D() |=  (1 << 1);
+)
+Z80_OP_CB(0xCB, // set 1,e
+	E() |=  (1 << 1);
+)
+Z80_OP_CB(0xCC, // set 1,h
+	H() |=  (1 << 1);
+)
+Z80_OP_CB(0xCD, // set 1,l
+	L() |=  (1 << 1);
+)
+Z80_OP_CB(0xCE, // set 1,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 1);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xCF, // set 1,a
+	A() |=  (1 << 1);
+)
+Z80_OP_CB(0xD0, // set 2,b
+	B() |=  (1 << 2);
+)
+Z80_OP_CB(0xD1, // set 2,c
+	C() |=  (1 << 2);
+)
+Z80_OP_CB(0xD2, // set 2,d
+	D() |=  (1 << 2);
+)
+Z80_OP_CB(0xD3, // set 2,e
+	E() |=  (1 << 2);
+)
+Z80_OP_CB(0xD4, // set 2,h
+	H() |=  (1 << 2);
+)
+Z80_OP_CB(0xD5, // set 2,l
+	L() |=  (1 << 2);
+)
+Z80_OP_CB(0xD6, // set 2,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 2);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xD7, // set 2,a
+	A() |=  (1 << 2);
+)
+Z80_OP_CB(0xD8, // set 3,b
+	B() |=  (1 << 3);
+)
+Z80_OP_CB(0xD9, // set 3,c
+	C() |=  (1 << 3);
+)
+Z80_OP_CB(0xDA, // set 3,d
+	D() |=  (1 << 3);
+)
+Z80_OP_CB(0xDB, // set 3,e
+	E() |=  (1 << 3);
+)
+Z80_OP_CB(0xDC, // set 3,h
+	H() |=  (1 << 3);
+)
+Z80_OP_CB(0xDD, // set 3,l
+	L() |=  (1 << 3);
+)
+Z80_OP_CB(0xDE, // set 3,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 3);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xDF, // set 3,a
+	A() |=  (1 << 3);
+)
+Z80_OP_CB(0xE0, // set 4,b
+	B() |=  (1 << 4);
+)
+Z80_OP_CB(0xE1, // set 4,c
+	C() |=  (1 << 4);
+)
+Z80_OP_CB(0xE2, // set 4,d
+	D() |=  (1 << 4);
+)
+Z80_OP_CB(0xE3, // set 4,e
+	E() |=  (1 << 4);
+)
+Z80_OP_CB(0xE4, // set 4,h
+	H() |=  (1 << 4);
+)
+Z80_OP_CB(0xE5, // set 4,l
+	L() |=  (1 << 4);
+)
+Z80_OP_CB(0xE6, // set 4,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 4);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xE7, // set 4,a
+	A() |=  (1 << 4);
+)
+Z80_OP_CB(0xE8, // set 5,b
+	B() |=  (1 << 5);
+)
+Z80_OP_CB(0xE9, // set 5,c
+	C() |=  (1 << 5);
+)
+Z80_OP_CB(0xEA, // set 5,d
+	D() |=  (1 << 5);
+)
+Z80_OP_CB(0xEB, // set 5,e
+	E() |=  (1 << 5);
+)
+Z80_OP_CB(0xEC, // set 5,h
+	H() |=  (1 << 5);
+)
+Z80_OP_CB(0xED, // set 5,l
+	L() |=  (1 << 5);
+)
+Z80_OP_CB(0xEE, // set 5,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 5);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xEF, // set 5,a
+	A() |=  (1 << 5);
+)
+Z80_OP_CB(0xF0, // set 6,b
+	B() |=  (1 << 6);
+)
+Z80_OP_CB(0xF1, // set 6,c
+	C() |=  (1 << 6);
+)
+Z80_OP_CB(0xF2, // set 6,d
+	D() |=  (1 << 6);
+)
+Z80_OP_CB(0xF3, // set 6,e
+	E() |=  (1 << 6);
+)
+Z80_OP_CB(0xF4, // set 6,h
+	H() |=  (1 << 6);
+)
+Z80_OP_CB(0xF5, // set 6,l
+	L() |=  (1 << 6);
+)
+Z80_OP_CB(0xF6, // set 6,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 6);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xF7, // set 6,a
+	A() |=  (1 << 6);
+)
+Z80_OP_CB(0xF8, // set 7,b
+	B() |=  (1 << 7);
+)
+Z80_OP_CB(0xF9, // set 7,c
+	C() |=  (1 << 7);
+)
+Z80_OP_CB(0xFA, // set 7,d
+	D() |=  (1 << 7);
+)
+Z80_OP_CB(0xFB, // set 7,e
+	E() |=  (1 << 7);
+)
+Z80_OP_CB(0xFC, // set 7,h
+	H() |=  (1 << 7);
+)
+Z80_OP_CB(0xFD, // set 7,l
+	L() |=  (1 << 7);
+)
+Z80_OP_CB(0xFE, // set 7,(hl)
+	t8 = loadB(HL);
+	t8 |=  (1 << 7);
+	storeB(HL, t8);
+)
+Z80_OP_CB(0xFF, // set 7,a
+	A() |=  (1 << 7);
+)
+
+// # --------------------------------------------------------------------------- 
+// # 0xED
+
+Z80_OP_ED(0x40, // in b,(c)
+	set_inc_flags(B() = in(C()));
+)
+Z80_OP_ED(0x41, // out (c),b
+	out(C(), B());
+)
+Z80_OP_ED(0x42, // sbc hl,bc
+	subHL(BC, true);
+)
+Z80_OP_ED(0x43, // ld (a16),bc
+	storeW(loadW(), BC);
+)
+Z80_OP_ED(0x48, // in c,(c)
+	set_inc_flags(C() = in(C()));
+)
+Z80_OP_ED(0x49, // out (c),c
+	out(C(), C());
+)
+Z80_OP_ED(0x4A, // adc hl,bc
+	addHL(BC, true);
+)
+Z80_OP_ED(0x4B, // ld bc,(a16)
+	BC = loadW(loadW());
+)
+Z80_OP_ED(0x50, // in d,(c)
+	set_inc_flags(D() = in(C()));
+)
+Z80_OP_ED(0x51, // out (c),d
+	out(C(), D());
+)
+Z80_OP_ED(0x52, // sbc hl,de
+	subHL(DE, true);
+)
+Z80_OP_ED(0x53, // ld (a16),de
+	storeW(loadW(), DE);
+)
+Z80_OP_ED(0x56, // im 1
+)
+Z80_OP_ED(0x58, // in e,(c)
+	set_inc_flags(E() = in(C()));
+)
+Z80_OP_ED(0x59, // out (c),e
+	out(C(), E());
+)
+Z80_OP_ED(0x5A, // adc hl,de
+	addHL(DE, true);
+)
+Z80_OP_ED(0x5B, // ld de,(a16)
+	DE = loadW(loadW());
+)
+Z80_OP_ED(0x60, // in h,(c)
+	set_inc_flags(H() = in(C()));
+)
+Z80_OP_ED(0x61, // out (c),h
+	out(C(), H());
+)
+Z80_OP_ED(0x62, // sbc hl,hl
+	subHL(HL, true);
+)
+Z80_OP_ED(0x63, // ld (a16),hl
+	storeW(loadW(), HL);
+)
+Z80_OP_ED(0x68, // in l,(c)
+	set_inc_flags(L() = in(C()));
+)
+Z80_OP_ED(0x69, // out (c),l
+	out(C(), L());
+)
+Z80_OP_ED(0x6A, // adc hl,hl
+	addHL(HL, true);
+)
+Z80_OP_ED(0x6B, // ld hl,(a16)
+	HL = loadW(loadW());
+)
+Z80_OP_ED(0x70, // in (c)
+	set_inc_flags(in(C()));
+)
+Z80_OP_ED(0x71, // out (c),0
+	out(C(), 0);
+)
+Z80_OP_ED(0x72, // sbc hl,sp
+	subHL(SP, true);
+)
+Z80_OP_ED(0x73, // ld (a16),sp
+	storeW(loadW(), SP);
+)
+Z80_OP_ED(0x78, // in a,(c)
+	set_inc_flags(A() = in(C()));
+)
+Z80_OP_ED(0x79, // out (c),a
+	out(C(), A());
+)
+Z80_OP_ED(0x7A, // adc hl,sp
+	addHL(SP, true);
+)
+Z80_OP_ED(0x7B, // ld sp,(a16)
+	SP = loadW(loadW());
+)
+
+// # --------------------------------------------------------------------------- 
+// # 0xDD / 0xFD
+
+Z80_OP_XY(0x09, // add ixy,bc
+	IXY += BC;
+)
+Z80_OP_XY(0x19, // add ixy,de
+	IXY += DE;
+)
+Z80_OP_XY(0x21, // ld ixy,d16
+	IXY = loadW();
+)
+Z80_OP_XY(0x22, // ld (a16),ixy
+	storeW(loadW(), IXY);
+)
+Z80_OP_XY(0x23, // inc ixy
+	++IXY;
+)
+Z80_OP_XY(0x29, // add ixy,ixy
+	IXY += IXY;
+)
+Z80_OP_XY(0x2A, // ld ixy,(a16)
+	IXY = loadW(loadW());
+)
+Z80_OP_XY(0x2B, // dec ixy
+	--IXY;
+)
+Z80_OP_XY(0x34, // inc (ixy+s8)
+	t16 = getOff(IXY, loadB());
+	t8 = loadW(t16) + 1;
+	storeB(t16, t8);
+	set_inc_flags(t8);
+)
+Z80_OP_XY(0x35, // dec (ixy+s8)
+	t16 = getOff(IXY, loadB());
+	t8 = loadW(t16) - 1;
+	storeB(t16, t8);
+	set_dec_flags(t8);
+)
+Z80_OP_XY(0x39, // add ixy,sp
+	IXY += SP;
+)
+Z80_OP_XY(0x46, // ld b,(ixy+s8)
+	B() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x4E, // ld c,(ixy+s8)
+	C() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x56, // ld d,(ixy+s8)
+	D() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x5E, // ld e,(ixy+s8)
+	E() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x66, // ld h,(ixy+s8)
+	H() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x6E, // ld l,(ixy+s8)
+	L() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x70, // ld (ixy+s8),b
+	storeB(getOff(IXY, loadB()), B());
+)
+Z80_OP_XY(0x71, // ld (ixy+s8),c
+	storeB(getOff(IXY, loadB()), C());
+)
+Z80_OP_XY(0x72, // ld (ixy+s8),d
+	storeB(getOff(IXY, loadB()), D());
+)
+Z80_OP_XY(0x73, // ld (ixy+s8),e
+	storeB(getOff(IXY, loadB()), E());
+)
+Z80_OP_XY(0x74, // ld (ixy+s8),h
+	storeB(getOff(IXY, loadB()), H());
+)
+Z80_OP_XY(0x75, // ld (ixy+s8),l
+	storeB(getOff(IXY, loadB()), L());
+)
+Z80_OP_XY(0x77, // ld (ixy+s8),a
+	storeB(getOff(IXY, loadB()), A());
+)
+Z80_OP_XY(0x7E, // ld a,(ixy+s8)
+	A() = loadB(getOff(IXY, loadB()));
+)
+Z80_OP_XY(0x86, // add a,(ixy+s8)
+	addA(loadB(getOff(IXY, loadB())), false);
+)
+Z80_OP_XY(0x8E, // adc a,(ixy+s8)
+	addA(loadB(getOff(IXY, loadB())), true);
+)
+Z80_OP_XY(0x96, // sub (ixy+s8)
+	subA(loadB(getOff(IXY, loadB())), false);
+)
+Z80_OP_XY(0x9E, // sbc a,(ixy+s8)
+	subA(loadB(getOff(IXY, loadB())), true);
+)
+Z80_OP_XY(0xA6, // and (ixy+s8)
+	logicA(A() & loadB(getOff(IXY, loadB())), true);
+)
+Z80_OP_XY(0xAE, // xor (ixy+s8)
+	logicA(A() ^ loadB(getOff(IXY, loadB())), false);
+)
+Z80_OP_XY(0xB6, // or (ixy+s8)
+	logicA(A() | loadB(getOff(IXY, loadB())), false);
+)
+Z80_OP_XY(0xBE, // cp (ixy+s8)
+	t8 = A();
+	subA(loadB(getOff(IXY, loadB())), false);
+	A() = t8;
+)
+Z80_OP_XY(0xE1, // pop ixy
+	IXY = popW();
+)
+Z80_OP_XY(0xE3, // ex (sp),ixy
+	SP += 2;
+	t16 = popW();
+	pushW(IXY);
+	IXY = t16;
+	SP -= 2;
+)
+Z80_OP_XY(0xE5, // push ixy
+	pushW(IXY);
+)
+Z80_OP_XY(0xE9, // jp (ixy)
+	PC = IXY;
+)
+Z80_OP_XY(0xF9, // ld sp,ixy
+	SP = IXY;
+)
+
+// # --------------------------------------------------------------------------- 
+// # 0xDDCB / 0xFDCB
+
+Z80_OP_XYCB(0x06, // rlc (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_left(t8, BIT_BIT7);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x0E, // rrc (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_right(t8, BIT_BIT7);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x16, // rl (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_left(t8, BIT_CARRY);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x1E, // rr (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_right(t8, BIT_CARRY);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x26, // sla (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_left(t8, BIT_A);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x2E, // sra (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_right(t8, BIT_A);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x36, // sll (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_left(t8, BIT_L);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x3E, // srl (ixy+s8)
+	t8 = loadB(t16 = getOff(IXY, t8));
+	rotate_right(t8, BIT_L);
+	storeB(t16, t8);
+)
+Z80_OP_XYCB(0x46, // bit 0,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 0);
+)
+Z80_OP_XYCB(0x4E, // bit 1,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 1);
+)
+Z80_OP_XYCB(0x56, // bit 2,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 2);
+)
+Z80_OP_XYCB(0x5E, // bit 3,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 3);
+)
+Z80_OP_XYCB(0x66, // bit 4,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 4);
+)
+Z80_OP_XYCB(0x6E, // bit 5,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 5);
+)
+Z80_OP_XYCB(0x76, // bit 6,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 6);
+)
+Z80_OP_XYCB(0x7E, // bit 7,(ixy+s8)
+	test_bit(loadB(getOff(IXY, t8)), 7);
+)
+Z80_OP_XYCB(0x86, // res 0,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 0));
+)
+Z80_OP_XYCB(0x8E, // res 1,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 1));
+)
+Z80_OP_XYCB(0x96, // res 2,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 2));
+)
+Z80_OP_XYCB(0x9E, // res 3,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 3));
+)
+Z80_OP_XYCB(0xA6, // res 4,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 4));
+)
+Z80_OP_XYCB(0xAE, // res 5,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 5));
+)
+Z80_OP_XYCB(0xB6, // res 6,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 6));
+)
+Z80_OP_XYCB(0xBE, // res 7,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) & ~(1 << 7));
+)
+Z80_OP_XYCB(0xC6, // set 0,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 0));
+)
+Z80_OP_XYCB(0xCE, // set 1,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 1));
+)
+Z80_OP_XYCB(0xD6, // set 2,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 2));
+)
+Z80_OP_XYCB(0xDE, // set 3,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 3));
+)
+Z80_OP_XYCB(0xE6, // set 4,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 4));
+)
+Z80_OP_XYCB(0xEE, // set 5,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 5));
+)
+Z80_OP_XYCB(0xF6, // set 6,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 6));
+)
+Z80_OP_XYCB(0xFE, // set 7,(ixy+s8)
+	t16 = getOff(IXY, t8);
+	storeB(t16, loadB(t16) | (1 << 7));
+)
+
+#undef Z80_OP_MAIN
+#undef Z80_OP_CB
+#undef Z80_OP_ED
+#undef Z80_OP_XY
+#undef Z80_OP_XYCB
+
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <map>
+
+#include "Profiler.h"
+#include "lib.h"
+
+namespace z80 {
+
+Profiler::Profiler(Z80& cpu)
+	: cpu_(&cpu)
+	, hits_(0x10000)
+	, cycles_(0x10000)
+	, total_(0)
+	, since_(0)
+	, last_(0)
+	, running_(false)
+{
+}
+
+Profiler::~Profiler(void)
+{
+	stop();
+}
+
+void Profiler::start(void)
+{
+	if(!running_)
+	{
+		last_ = cpu_->getPC();
+		since_ = cpu_->getCycles();
+		running_ = true;
+		cpu_->setProfiler(this);
+	}
+}
+
+// Charges the instruction in progress before letting go of the cpu.
+void Profiler::stop(void)
+{
+	if(running_)
+	{
+		uint64_t now = cpu_->getCycles();
+		uint64_t d = now > since_ ? now - since_ : 0;
+
+		cycles_[last_] += d;
+		total_ += d;
+		running_ = false;
+		cpu_->setProfiler(nullptr);
+	}
+}
+
+void Profiler::clear(void)
+{
+	std::fill(hits_.begin(), hits_.end(), 0);
+	std::fill(cycles_.begin(), cycles_.end(), 0);
+	total_ = 0;
+}
+
+// On a logarithmic scale of the share of all cycles, from 0 (never ran)
+// to HEAT (half of the time or more).
+uint Profiler::getHeat(uint16_t a) const
+{
+	uint64_t c = cycles_[a];
+
+	if(!c)
+	{
+		return 0;
+	}
+
+	uint h = HEAT;
+
+	while(h > 1 && (c << (HEAT - h + 1)) < total_)
+	{
+		--h;
+	}
+
+	return h;
+}
+
+// Folds the addresses into the routines of the symbols, or lists them
+// one by one if there are none, hottest first.
+std::vector<Profiler::Entry> Profiler::report(const Symbols& symbols) const
+{
+	std::map<uint16_t, Entry> routines;
+
+	for(uint a = 0 ; a < 0x10000 ; ++a)
+	{
+		if(!hits_[a] && !cycles_[a])
+		{
+			continue;
+		}
+
+		Entry e { lib::stringf("$%04X", a), (uint16_t) a, 0, 0 };
+
+		symbols.getRoutine(a, e.addr, e.name);
+
+		Entry& r(routines.insert(std::make_pair(e.addr, e)).first->second);
+
+		r.hits += hits_[a];
+		r.cycles += cycles_[a];
+	}
+
+	std::vector<Entry> v;
+
+	for(const auto& p : routines)
+	{
+		v.push_back(p.second);
+	}
+
+	std::stable_sort(v.begin(), v.end(), [](const Entry& e1, const Entry& e2) { return e1.cycles > e2.cycles; });
+
+	return v;
+}
+
+}
+
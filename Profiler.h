@@ -0,0 +1,66 @@
+#ifndef Z80_PROFILER_H
+#define Z80_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "Z80.h"
+#include "Symbols.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Exact per-address profile of the guest: how often every instruction
+	// ran and how many cycles it took. Each instruction is charged the
+	// cycles that passed until the next one started, so time spent in a
+	// halt or taking an interrupt goes to the instruction before it.
+	class Profiler
+	{
+		public:
+			static const uint HEAT = 8;
+
+			struct Entry
+			{
+				std::string name;
+				uint16_t addr;
+				uint64_t hits, cycles;
+			};
+
+		public:
+			Profiler(Z80&);
+			~Profiler( );
+			void start( );
+			void stop( );
+			void clear( );
+			bool isRunning( ) const { return running_; }
+			inline void step(uint16_t, uint64_t);
+			uint64_t getHits(uint16_t a) const { return hits_[a]; }
+			uint64_t getCycles(uint16_t a) const { return cycles_[a]; }
+			uint64_t getTotal( ) const { return total_; }
+			uint getHeat(uint16_t) const;
+			std::vector<Entry> report(const Symbols&) const;
+		private:
+			Z80 *cpu_;
+			std::vector<uint64_t> hits_, cycles_;
+			uint64_t total_, since_;
+			uint16_t last_;
+			bool running_;
+	};
+
+	// Rewinding moves the clock backwards; that time is lost.
+	void Profiler::step(uint16_t pc, uint64_t now)
+	{
+		uint64_t d = now > since_ ? now - since_ : 0;
+
+		cycles_[last_] += d;
+		total_ += d;
+		++hits_[pc];
+		last_ = pc;
+		since_ = now;
+	}
+}
+
+#endif
+
@@ -0,0 +1,58 @@
+#ifndef LIB_QUEUE_H
+#define LIB_QUEUE_H
+
+#include <atomic>
+#include <utility>
+#include <stddef.h>
+
+namespace lib
+{
+	// A bounded queue between exactly one producer and one consumer
+	// thread. The producer only ever moves the tail and the consumer the
+	// head, so neither needs a lock; a full queue just refuses the push.
+	template<typename T, size_t N>
+	class Queue
+	{
+		static_assert(N && !(N & (N - 1)), "Queue size must be a power of two!");
+
+		public:
+			Queue( ) : head_(0), tail_(0) { }
+			Queue(const Queue<T, N>&) = delete;
+			Queue<T, N>& operator=(const Queue<T, N>&) = delete;
+			bool push(T v)
+			{
+				size_t t = tail_.load(std::memory_order_relaxed);
+
+				if(t - head_.load(std::memory_order_acquire) == N)
+				{
+					return false;
+				}
+
+				buf_[t & (N - 1)] = std::move(v);
+				tail_.store(t + 1, std::memory_order_release);
+
+				return true;
+			}
+			bool pop(T& v)
+			{
+				size_t h = head_.load(std::memory_order_relaxed);
+
+				if(h == tail_.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+
+				v = std::move(buf_[h & (N - 1)]);
+				buf_[h & (N - 1)] = T();
+				head_.store(h + 1, std::memory_order_release);
+
+				return true;
+			}
+		private:
+			T buf_[N];
+			std::atomic<size_t> head_, tail_;
+	};
+}
+
+#endif
+
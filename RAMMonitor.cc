@@ -148,7 +148,7 @@ void RAMMonitor::onRender(void)
 
 		for(uint i = 0 ; i < 16 ; ++i)
 		{
-			int v = access_(i + a1 * 16);
+			int v = read_(i + a1 * 16);
 
 			if(v >= 0 && v < 0x100)
 			{
@@ -165,7 +165,11 @@ void RAMMonitor::onRender(void)
 	
 	if(msg_.size() > WIN_WIDTH) msg_ = "ERR: Msg too large!";
 
-	std::string message = msg_.empty() ? disassemble(&access_(addr_)).literal : msg_;
+	uint8_t ins[4];
+
+	for(uint i = 0 ; i < 4 ; ++i) ins[i] = read_(addr_ + i);
+
+	std::string message = msg_.empty() ? disassemble(ins).literal : msg_;
 	color = msg_.empty() ? 0 : 4;
 	x = WIN_WIDTH - message.size();
 	outStr(message, false);
@@ -255,8 +259,9 @@ void RAMMonitor::onEventDefault(const SDL_Event& e)
 					case SDLK_e:
 					case SDLK_f:
 						state_ = State::EDITING;
-						buf_ = access_(addr_);
-						access_(addr_) = (buf_ & 0x0F) | (key_[e.key.keysym.sym] << 4);
+						buf_ = read_(addr_);
+						edit_ = (buf_ & 0x0F) | (key_[e.key.keysym.sym] << 4);
+						write_(addr_, edit_);
 						updateCursor(Position(7 + (addr_ % 0x10) * 3 + 1, 2 + (addr_ - vOff_) / 0x10));
 						enableBlink(true);
 						break;
@@ -376,13 +381,14 @@ void RAMMonitor::onEventEditing(const SDL_Event& e)
 				case SDLK_d:
 				case SDLK_e:
 				case SDLK_f:
-					access_(addr_) = (access_(addr_) & 0xF0) | key_[e.key.keysym.sym];
-					push(undo_, addr_, buf_, access_(addr_));
+					edit_ = (edit_ & 0xF0) | key_[e.key.keysym.sym];
+					write_(addr_, edit_);
+					push(undo_, addr_, buf_, edit_);
 					gotoAddr(addr_ + 1);
 					state_ = State::DEFAULT;
 					break;
 				case SDLK_ESCAPE:
-					access_(addr_) = buf_;
+					write_(addr_, buf_);
 					state_ = State::DEFAULT;
 					break;
 			}
@@ -397,7 +403,7 @@ void RAMMonitor::onEventEditing(const SDL_Event& e)
 
 std::string RAMMonitor::renderDefault(void)
 {
-	return lib::stringf("$%04X: 0x%02X", addr_, access_(addr_));
+	return lib::stringf("$%04X: 0x%02X", addr_, read_(addr_));
 }
 
 std::string RAMMonitor::renderGoto(void)
@@ -467,7 +473,7 @@ void RAMMonitor::act(stack_t& s1, stack_t& s2)
 
 	gotoAddr(c.addr);
 
-	access_(addr_) = c.prev;
+	write_(addr_, c.prev);
 
 	push(s2, c.addr, c.next, c.prev);
 }
@@ -29,7 +29,8 @@ namespace z80
 		};
 
 		public:
-		typedef std::function<uint8_t&(uint16_t)> access_fn;
+		typedef std::function<uint8_t(uint16_t)> read_fn;
+		typedef std::function<void(uint16_t, uint8_t)> write_fn;
 		typedef std::function<std::string(void)> render_fn;
 		typedef std::stack<Change> stack_t;
 
@@ -37,7 +38,7 @@ namespace z80
 			RAMMonitor(uint = MXT_VIEWSIZE);
 			virtual ~RAMMonitor( );
 			void setAddress(uint);
-			void setAccess(access_fn f) { access_ = f; }
+			void setAccess(read_fn r, write_fn w) { read_ = r; write_ = w; }
 		private:
 			void onUpdate(uint);
 			void onRender( );
@@ -59,11 +60,12 @@ namespace z80
 
 		private:
 			uint16_t viewsize_, addr_, vOff_;
-			access_fn access_;
+			read_fn read_;
+			write_fn write_;
 			render_fn renderFooder_;
 			std::string msg_;
 			State state_;
-			uint8_t buf_;
+			uint8_t buf_, edit_;
 			std::map<uint, uint8_t> key_;
 			stack_t undo_, redo_;
 			uint8_t aBuf_[4];
@@ -0,0 +1,172 @@
+#include <vector>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "Recompiler.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MXT_X64
+#endif
+
+// Upper bound of the code emitted per micro-op, exit stub included.
+#define MXT_OP_SIZE 96
+#define MXT_FRAME_SIZE 32
+
+namespace z80 {
+
+Recompiler::Recompiler(void)
+	: mem_(nullptr)
+	, p_(nullptr)
+	, used_(0)
+{
+}
+
+Recompiler::~Recompiler(void)
+{
+	if(mem_)
+	{
+#ifdef _WIN32
+		VirtualFree(mem_, 0, MEM_RELEASE);
+#else
+		munmap(mem_, ARENA_SIZE);
+#endif
+	}
+}
+
+bool Recompiler::isSupported(void)
+{
+#ifdef MXT_X64
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Returns nullptr if the arena is exhausted; the caller is expected to
+// drop all native blocks and reset().
+BlockCache::native_fn Recompiler::compile(const BlockCache::MicroOp *ops, uint n, const Layout& l)
+{
+	if(!mem_)
+	{
+#ifdef _WIN32
+		mem_ = (uint8_t *) VirtualAlloc(nullptr, ARENA_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+		void *m = mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		mem_ = (m == MAP_FAILED) ? nullptr : (uint8_t *) m;
+#endif
+
+		if(!mem_)
+		{
+			throw std::string("Failed to map memory for the recompiler!");
+		}
+	}
+
+	if(used_ + n * MXT_OP_SIZE + MXT_FRAME_SIZE > ARENA_SIZE)
+	{
+		return nullptr;
+	}
+
+	uint8_t *start = p_ = mem_ + used_;
+	std::vector<uint8_t *> exits(2 * n);
+
+	emit(0x53);                                         // push rbx
+#ifdef _WIN32
+	emit(0x48); emit(0x83); emit(0xEC); emit(0x20);     // sub rsp,32
+	emit(0x48); emit(0x89); emit(0xCB);                 // mov rbx,rcx
+#else
+	emit(0x48); emit(0x89); emit(0xFB);                 // mov rbx,rdi
+#endif
+
+	for(uint i = 0 ; i < n ; ++i)
+	{
+		const BlockCache::MicroOp& op(ops[i]);
+
+		emit(0x66); emit(0xC7); emit(0x83);                 // mov word [rbx+pc],imm16
+		emit32(l.pc); emit16(op.pc + op.len);
+		emit(0x48); emit(0x83); emit(0x83);                 // add qword [rbx+cycles],imm8
+		emit32(l.cycles); emit(op.cycles);
+
+#ifdef _WIN32
+		emit(0x48); emit(0x89); emit(0xD9);                 // mov rcx,rbx
+		emit(0xBA); emit32(op.ins);                         // mov edx,ins
+		emit(0x41); emit(0xB8); emit32(op.t8);              // mov r8d,t8
+#else
+		emit(0x48); emit(0x89); emit(0xDF);                 // mov rdi,rbx
+		emit(0xBE); emit32(op.ins);                         // mov esi,ins
+		emit(0xBA); emit32(op.t8);                          // mov edx,t8
+#endif
+		emit(0x48); emit(0xB8); emit64((uintptr_t) op.fn);  // mov rax,fn
+		emit(0xFF); emit(0xD0);                             // call rax
+
+		if(i + 1 < n)
+		{
+			emit(0x80); emit(0xBB); emit32(l.abort); emit(0);   // cmp byte [rbx+abort],0
+			emit(0x0F); emit(0x85);                             // jne exit_i
+			exits[2 * i] = p_; emit32(0);
+			emit(0x66); emit(0x81); emit(0xBB);                 // cmp word [rbx+pc],imm16
+			emit32(l.pc); emit16(ops[i + 1].pc);
+			emit(0x0F); emit(0x85);                             // jne exit_i
+			exits[2 * i + 1] = p_; emit32(0);
+		}
+	}
+
+	emit(0xB8); emit32(n);                              // mov eax,n
+
+	uint8_t *epilogue = p_;
+
+#ifdef _WIN32
+	emit(0x48); emit(0x83); emit(0xC4); emit(0x20);     // add rsp,32
+#endif
+	emit(0x5B);                                         // pop rbx
+	emit(0xC3);                                         // ret
+
+	for(uint i = 0 ; i + 1 < n ; ++i)
+	{
+		patch(exits[2 * i], p_);
+		patch(exits[2 * i + 1], p_);
+		emit(0xB8); emit32(i + 1);                      // mov eax,i+1
+		emit(0xE9); emit32(0);                          // jmp epilogue
+		patch(p_ - 4, epilogue);
+	}
+
+	used_ = (p_ - mem_ + 15) & ~(size_t) 15;
+
+	return (BlockCache::native_fn) start;
+}
+
+void Recompiler::emit16(uint16_t v)
+{
+	emit(v & 0xFF);
+	emit(v >> 8);
+}
+
+void Recompiler::emit32(uint32_t v)
+{
+	emit16(v & 0xFFFF);
+	emit16(v >> 16);
+}
+
+void Recompiler::emit64(uint64_t v)
+{
+	emit32(v & 0xFFFFFFFF);
+	emit32(v >> 32);
+}
+
+// Points the rel32 at 'at' to 'to'.
+void Recompiler::patch(uint8_t *at, const uint8_t *to)
+{
+	int32_t d = to - (at + 4);
+
+	at[0] = d & 0xFF;
+	at[1] = (d >> 8) & 0xFF;
+	at[2] = (d >> 16) & 0xFF;
+	at[3] = (d >> 24) & 0xFF;
+}
+
+}
+
@@ -0,0 +1,56 @@
+#ifndef Z80_RECOMPILER_H
+#define Z80_RECOMPILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "BlockCache.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Translates cached blocks into x86-64 code. Every micro-op becomes a
+	// direct call of its handler, preceded by the PC and T-state update the
+	// interpreter would do. After each call the code leaves the block if
+	// the PC went elsewhere or the abort flag was raised by a write to a
+	// code page. The generated function returns the number of instructions
+	// it executed.
+	// Code is bump-allocated from one executable arena and only released
+	// all at once, so a block invalidated while it runs stays mapped.
+	class Recompiler
+	{
+		public:
+			// Offsets of the fields the generated code touches, relative
+			// to the Z80 object passed in.
+			struct Layout
+			{
+				int32_t pc, cycles, abort;
+			};
+
+			static const uint THRESHOLD = 32;
+			static const size_t ARENA_SIZE = 4 << 20;
+
+		public:
+			Recompiler( );
+			Recompiler(const Recompiler&) : Recompiler( ) { }
+			~Recompiler( );
+			Recompiler& operator=(const Recompiler&) { reset(); return *this; }
+			static bool isSupported( );
+			BlockCache::native_fn compile(const BlockCache::MicroOp *, uint, const Layout&);
+			void reset( ) { used_ = 0; }
+		private:
+			void emit(uint8_t b) { *p_++ = b; }
+			void emit16(uint16_t);
+			void emit32(uint32_t);
+			void emit64(uint64_t);
+			void patch(uint8_t *, const uint8_t *);
+
+		private:
+			uint8_t *mem_, *p_;
+			size_t used_;
+	};
+}
+
+#endif
+
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <string>
+
+#include "Rewind.h"
+
+namespace z80 {
+
+Rewind::Rewind(Z80& cpu, size_t steps, uint checkpoints, uint64_t interval)
+	: cpu_(&cpu)
+	, head_(0)
+	, first_(0)
+	, last_(0)
+	, written_(0)
+	, base_(0)
+	, end_(0)
+	, epoch_(0)
+	, next_(0)
+	, maxCheckpoints_(checkpoints)
+	, interval_(interval)
+{
+	if(!steps || !interval)
+	{
+		throw std::string("Invalid rewind buffer size!");
+	}
+
+	size_t n = 1;
+
+	while(n < steps) n <<= 1;
+
+	// no instruction writes more than two bytes, and most keyframes are
+	// a whole span apart
+	frames_.resize(std::max<size_t>(n / 4, 1));
+	writes_.resize(2 * n);
+	frameMask_ = frames_.size() - 1;
+	writeMask_ = 2 * n - 1;
+
+	setHandlers(
+		[this](Snapshot& s) { cpu_->save(s); },
+		[this](Snapshot& s) { cpu_->restore(s); });
+
+	cpu_->setRewind(this);
+}
+
+Rewind::~Rewind(void)
+{
+	cpu_->setRewind(nullptr);
+}
+
+// The handlers save and restore the whole machine, cpu included, in
+// the order of a Snapshot.
+void Rewind::setHandlers(save_fn save, restore_fn restore)
+{
+	save_ = save;
+	restore_ = restore;
+}
+
+// Undoes the last instruction. Returns false if there is no more history.
+bool Rewind::back(void)
+{
+	if(first_ == last_ || head_ == frames_[first_ & frameMask_].step)
+	{
+		return false;
+	}
+
+	uint64_t target = head_ - 1;
+
+	// keyframes taken since lie in the future now
+	while(frames_[(last_ - 1) & frameMask_].step > target)
+	{
+		--last_;
+	}
+
+	const Frame& f(frames_[(last_ - 1) & frameMask_]);
+
+	load(f);
+
+	// the replay neither starts keyframes nor takes checkpoints
+	epoch_ = cpu_->getEpoch();
+	end_ = next_ = -1;
+
+	cpu_->replay(target - f.step);
+
+	end_ = head_;
+	prune();
+
+	return true;
+}
+
+// Goes back 't' cycles, through the journal as far as it reaches, then to
+// the latest checkpoint at or before the target (or the oldest one, if
+// none is old enough). Returns how many cycles were actually rewound.
+uint64_t Rewind::rewind(uint64_t t)
+{
+	uint64_t start = cpu_->getCycles();
+	uint64_t target = start - std::min(t, start);
+
+	// a whole span at a time, then single steps within the last one
+	while(last_ - first_ > 1 && frames_[(last_ - 1) & frameMask_].regs.cycles > target)
+	{
+		load(frames_[--last_ & frameMask_]);
+	}
+
+	while(cpu_->getCycles() > target && back());
+
+	if(cpu_->getCycles() > target && !checkpoints_.empty())
+	{
+		while(checkpoints_.size() > 1 && checkpoints_.back().cycles > target)
+		{
+			checkpoints_.pop_back();
+		}
+
+		Snapshot& s(checkpoints_.back().state);
+
+		s.rewind();
+		restore_(s);
+
+		// the journal can't lead back to where it was recorded anymore
+		first_ = last_;
+		base_ = written_;
+	}
+
+	end_ = head_;
+	prune();
+
+	return start - cpu_->getCycles();
+}
+
+void Rewind::clear(void)
+{
+	first_ = last_;
+	base_ = written_;
+	end_ = head_;
+	checkpoints_.clear();
+	next_ = 0;
+}
+
+size_t Rewind::getMemory(void) const
+{
+	size_t n = frames_.capacity() * sizeof(Frame) + writes_.capacity() * sizeof(Write);
+
+	for(const Checkpoint& c : checkpoints_)
+	{
+		n += c.state.size();
+	}
+
+	return n;
+}
+
+// Keeps the registers from before the next instruction. Code that sees
+// memory other than the cpu's own RAM might read something different a
+// second time, so it isn't replayed at all.
+void Rewind::keyframe(void)
+{
+	const Memory& m(cpu_->getMemory());
+	uint span = SPAN;
+
+	for(uint i = 0 ; i < Memory::PAGES ; ++i)
+	{
+		if(!m.getGeneration(i)) span = 1;
+	}
+
+	if(last_ - first_ > frameMask_)
+	{
+		drop();
+	}
+
+	frames_[last_++ & frameMask_] = Frame { cpu_->getRegisters(), head_, written_ };
+
+	if(last_ - first_ == 1)
+	{
+		base_ = written_;
+	}
+
+	epoch_ = cpu_->getEpoch();
+	end_ = head_ + span;
+}
+
+// Forgets the oldest keyframe, and with it the steps up to the next one.
+void Rewind::drop(void)
+{
+	if(first_ != last_)
+	{
+		++first_;
+	}
+
+	if(first_ == last_)
+	{
+		base_ = written_;
+		end_ = head_;
+	}
+	else
+	{
+		base_ = frames_[first_ & frameMask_].writes;
+	}
+}
+
+// Undoes every write since the keyframe and puts its registers back.
+void Rewind::load(const Frame& f)
+{
+	while(written_ > f.writes)
+	{
+		const Write& w(writes_[--written_ & writeMask_]);
+
+		cpu_->poke(w.addr, w.old);
+	}
+
+	cpu_->setRegisters(f.regs);
+	head_ = f.step;
+}
+
+// Checkpoints taken since the current cycle lie in the future now.
+void Rewind::prune(void)
+{
+	while(!checkpoints_.empty() && checkpoints_.back().cycles > cpu_->getCycles())
+	{
+		checkpoints_.pop_back();
+	}
+
+	next_ = checkpoints_.empty() ? cpu_->getCycles() : checkpoints_.back().cycles + interval_;
+}
+
+void Rewind::checkpoint(void)
+{
+	next_ = cpu_->getCycles() + interval_;
+
+	if(!maxCheckpoints_)
+	{
+		return;
+	}
+
+	checkpoints_.push_back(Checkpoint { cpu_->getCycles(), Snapshot() });
+	save_(checkpoints_.back().state);
+
+	if(checkpoints_.size() > maxCheckpoints_)
+	{
+		checkpoints_.pop_front();
+	}
+}
+
+}
+
@@ -0,0 +1,125 @@
+#ifndef Z80_REWIND_H
+#define Z80_REWIND_H
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+#include "Z80.h"
+#include "Snapshot.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Execution history of a cpu, to step backwards through. Every
+	// instruction leaves the old contents of every byte it writes in a
+	// bounded journal, while the registers are only kept in keyframes:
+	// every SPAN instructions, and before any instruction that follows
+	// something a second run couldn't repeat (a port access, a device
+	// event, a change from the outside; anything that moves the cpu's
+	// epoch). Stepping back undoes the writes back to the last keyframe
+	// and replays the cpu from there up to the instruction before.
+	// Further back than the journal reaches, rewinding falls back to the
+	// full checkpoints taken every so many cycles, which also cover the
+	// peripherals if the owner provides save/restore handlers. Writes to
+	// devices and anything a peripheral did in the meantime are not undone
+	// by stepping back, only by restoring a checkpoint; code that sees
+	// memory other than the cpu's own RAM gets a keyframe every
+	// instruction.
+	// Recording costs the table engine about 5% of its speed on a tight
+	// loop; a cpu without a Rewind attached pays one branch per
+	// instruction and write.
+	class Rewind
+	{
+		public:
+			typedef std::function<void(Snapshot&)> save_fn;
+			typedef std::function<void(Snapshot&)> restore_fn;
+
+			static const size_t STEPS = 1 << 18;
+			static const uint CHECKPOINTS = 16;
+			static const uint64_t INTERVAL = 10000000;
+			static const uint SPAN = 64;
+
+		public:
+			Rewind(Z80&, size_t = STEPS, uint = CHECKPOINTS, uint64_t = INTERVAL);
+			~Rewind( );
+			void setHandlers(save_fn, restore_fn);
+			inline void step(const Z80&);
+			inline void write(uint16_t, uint8_t);
+			bool back( );
+			uint64_t rewind(uint64_t);
+			void clear( );
+			size_t getSteps( ) const { return first_ == last_ ? 0 : head_ - frames_[first_ & frameMask_].step; }
+			uint getCheckpoints( ) const { return checkpoints_.size(); }
+			size_t getMemory( ) const;
+		private:
+			struct Frame
+			{
+				Z80::Registers regs;
+				uint64_t step, writes;
+			};
+
+			struct Write
+			{
+				uint16_t addr;
+				uint8_t old;
+			};
+
+			struct Checkpoint
+			{
+				uint64_t cycles;
+				Snapshot state;
+			};
+
+			void keyframe( );
+			void drop( );
+			void load(const Frame&);
+			void prune( );
+			void checkpoint( );
+
+		private:
+			Z80 *cpu_;
+			save_fn save_;
+			restore_fn restore_;
+			std::vector<Frame> frames_;
+			std::vector<Write> writes_;
+			std::deque<Checkpoint> checkpoints_;
+			uint64_t frameMask_, writeMask_;
+			uint64_t head_, first_, last_, written_, base_, end_, epoch_, next_;
+			uint maxCheckpoints_;
+			uint64_t interval_;
+	};
+
+	// Between keyframes a step is no more than a count.
+	void Rewind::step(const Z80& cpu)
+	{
+		if(cpu.getCycles() >= next_)
+		{
+			checkpoint();
+		}
+
+		if(head_ >= end_ || cpu.getEpoch() != epoch_)
+		{
+			keyframe();
+		}
+
+		++head_;
+	}
+
+	// The journal is a ring of a power of two entries; once it would
+	// overwrite a write from before the oldest keyframe, that one goes.
+	void Rewind::write(uint16_t a, uint8_t v)
+	{
+		writes_[written_++ & writeMask_] = Write { a, v };
+
+		if(written_ - base_ > writeMask_)
+		{
+			drop();
+		}
+	}
+}
+
+#endif
+
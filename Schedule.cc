@@ -1,45 +1,83 @@
+#include <algorithm>
+
 #include "Schedule.h"
 
 namespace lib {
 
+namespace
+{
+	struct Later
+	{
+		template<typename T>
+		bool operator()(const T& e1, const T& e2) const { return e1.when > e2.when; }
+	};
+}
+
+Schedule::Schedule(void)
+{
+	timer_.reset();
+}
+
+// 'f' is the period in microseconds.
 void Schedule::schedule(run_fn cb, uint64_t f)
 {
-	Timer t;
+	f = std::max<uint64_t>(f, 1);
 
-	t.reset();
-	callbacks_.push_back(std::make_pair(std::make_pair(f, 0ul), std::make_pair(t, cb)));
+	push(wall_, Event { timer_.get().count() + f, f, cb });
 }
 
 void Schedule::step(void)
 {
-	Timer t;
-	uint64_t c = (uint64_t)-1, e;
+	run(wall_, timer_.get().count());
 
-	t.reset();
+	uint64_t deadline = wall_.empty() ? timer_.get().count() + MAX_SLEEP : wall_.front().when;
+	uint64_t now, wake = deadline;
 
-	for(auto& p : callbacks_)
+	while(bulk_ && (now = timer_.get().count()) < deadline)
 	{
-		uint64_t r = p.first.second + p.second.first.elapsed().count();
-
-		if(r >= p.first.first)
-		{
-			r -= p.first.first;
-			c = 0;
-			p.second.second();
-		}
-		else if(c > 0 && r < c)
+		if(uint64_t w = bulk_())
 		{
-			c = r;
+			wake = std::min(deadline, w == IDLE ? deadline : now + w);
+
+			break;
 		}
+	}
 
-		p.first.second = r;
+	now = timer_.get().count();
+
+	if(now < wake)
+	{
+		timer_.sleep(Timer::time_t(wake - now));
 	}
+}
 
-	e = t.elapsed().count();
+void Schedule::push(heap_t& h, const Event& e)
+{
+	h.push_back(e);
+	std::push_heap(h.begin(), h.end(), Later());
+}
 
-	if(c > 0 && c > e)
+// An event that fell behind by more than a period skips the ones it
+// missed instead of firing them all at once.
+void Schedule::run(heap_t& h, uint64_t now)
+{
+	while(!h.empty() && h.front().when <= now)
 	{
-		t.sleep(Timer::time_t(c - e));
+		std::pop_heap(h.begin(), h.end(), Later());
+
+		Event e(h.back());
+
+		h.pop_back();
+
+		e.f();
+		e.when += e.period;
+
+		if(e.when <= now)
+		{
+			e.when = now + e.period;
+		}
+
+		push(h, e);
 	}
 }
 
@@ -3,21 +3,49 @@
 
 #include <vector>
 #include <functional>
+#include <stdint.h>
 
 #include "Timer.h"
 
 namespace lib
 {
+	// Periodic events in wall time, in microseconds. The events are kept
+	// in a min-heap on their next deadline, so a step only ever looks at
+	// the earliest one. Between two events the bulk handler gets to run
+	// the cpu. It returns how many microseconds it has nothing to do for
+	// (IDLE if not until something else happens), and the schedule
+	// sleeps for that long or until the next deadline, whichever comes
+	// first. Guest-time events live in the cpu's own queue (z80::Events).
 	class Schedule
 	{
 		public:
 		typedef std::function<void(void)> run_fn;
+		typedef std::function<uint64_t(void)> bulk_fn;
+
+		static const uint64_t MAX_SLEEP = 100000;
+		static const uint64_t IDLE = (uint64_t) -1;
 
 		public:
+			Schedule( );
 			void schedule(run_fn, uint64_t);
+			void setBulk(bulk_fn f) { bulk_ = f; }
 			void step( );
 		private:
-			std::vector<std::pair<std::pair<uint64_t, uint64_t>, std::pair<Timer, run_fn>>> callbacks_;
+			struct Event
+			{
+				uint64_t when, period;
+				run_fn f;
+			};
+
+			typedef std::vector<Event> heap_t;
+
+			static void push(heap_t&, const Event&);
+			static void run(heap_t&, uint64_t);
+
+		private:
+			Timer timer_;
+			heap_t wall_;
+			bulk_fn bulk_;
 	};
 }
 
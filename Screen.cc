@@ -1,12 +1,35 @@
+#include <algorithm>
+
 #include "Screen.h"
 
 namespace z80 {
 
 Screen::Screen(void)
+	: vram_(new std::array<uint8_t, COLS*ROWS>())
 {
 	timerEn_ = false;
 }
 
+void Screen::save(Snapshot& s) const
+{
+	s.write(vram_->data(), COLS * ROWS);
+	s.write8(cx_);
+	s.write8(cy_);
+	s.write8(status_);
+	s.write8(id_);
+	s.write8(timerEn_);
+}
+
+void Screen::restore(Snapshot& s)
+{
+	s.read(VRAM(), COLS * ROWS);
+	cx_ = s.read8();
+	cy_ = s.read8();
+	status_ = s.read8();
+	id_ = s.read8();
+	timerEn_ = s.read8();
+}
+
 Screen::~Screen(void)
 {
 }
@@ -48,7 +71,7 @@ uint8_t Screen::read(uint8_t port)
 	switch(port)
 	{
 		case 0x00: // data port
-			return vram_[cx_ + cy_ * COLS];
+			return (*vram_)[cx_ + cy_ * COLS];
 		case 0x01: // cursor x
 			return cx_;
 		case 0x02: // cursor y
@@ -67,10 +90,7 @@ void Screen::command(uint8_t data)
 	switch(data)
 	{
 		case 0x00: // clear screen
-			for(uint i = 0 ; i < COLS*ROWS ; ++i)
-			{
-				vram_[i] = 0;
-			}
+			std::fill_n(VRAM(), COLS*ROWS, 0);
 			cx_ = cy_ = 0;
 			break;
 		case 0x01: // scroll
@@ -86,19 +106,31 @@ void Screen::command(uint8_t data)
 	}
 }
 
+uint8_t *Screen::VRAM(void)
+{
+	if(vram_.use_count() > 1)
+	{
+		vram_.reset(new std::array<uint8_t, COLS*ROWS>(*vram_));
+	}
+
+	return vram_->data();
+}
+
 void Screen::do_scroll(void)
 {
+	uint8_t *vram = VRAM();
+
 	for(uint i = 1 ; i < ROWS ; ++i)
 	{
 		for(uint j = 0 ; j < COLS ; ++j)
 		{
-			vram_[j + (i - 1) * COLS] = vram_[j + i * COLS];
+			vram[j + (i - 1) * COLS] = vram[j + i * COLS];
 		}
 	}
 
 	for(uint i = 0 ; i < COLS; ++i)
 	{
-		vram_[i + (ROWS - 1) * COLS] = 0;
+		vram[i + (ROWS - 1) * COLS] = 0;
 	}
 }
 
@@ -129,7 +161,7 @@ void Screen::writeToVRAM(uint8_t data)
 			if(cy_ < ROWS-1) ++cy_;
 			break;
 		default:
-			vram_[cx_ + cy_ * COLS] = data;
+			VRAM()[cx_ + cy_ * COLS] = data;
 			if(advX())
 			{
 				if(cx_ >= COLS-1)
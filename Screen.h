@@ -1,11 +1,16 @@
 #ifndef Z80_SCREEN_H
 #define Z80_SCREEN_H
 
+#include <array>
+#include <memory>
+
 #include "Peripheral.h"
 #include "Property.h"
+#include "Snapshot.h"
 
 namespace z80
 {
+	// Copies share their VRAM until either side writes to it.
 	class Screen : public Peripheral
 	{
 		public:
@@ -30,15 +35,19 @@ namespace z80
 			bool timer_en()		{ return timerEn_; }
 			uint8_t getCursorX( ) const { return cx_; }
 			uint8_t getCursorY( ) const { return cy_; }
-			uint8_t getChar(uint x, uint y) const { return vram_[x + y * COLS]; }
+			uint8_t getChar(uint x, uint y) const { return (*vram_)[x + y * COLS]; }
+			bool isVRAMShared( ) const { return vram_.use_count() > 1; }
 			void reset( );
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
 		private:
 			void command(uint8_t);
 			void do_scroll( );
 			void writeToVRAM(uint8_t);
+			uint8_t *VRAM( );
 
 		private:
-			uint8_t vram_[COLS*ROWS];
+			std::shared_ptr<std::array<uint8_t, COLS*ROWS>> vram_;
 			uint8_t cx_, cy_;
 			uint8_t status_;
 			uint8_t id_ = 0;
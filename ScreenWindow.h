@@ -1,32 +1,32 @@
 #ifndef Z80_SCREENWINDOW_H
 #define Z80_SCREENWINDOW_H
 
+#include <functional>
+
 #include "CharacterWindow.h"
 #include "Image.h"
-#include "Screen.h"
-#include "Keyboard.h"
-#include "Property.h"
+#include "Frames.h"
 
 namespace z80
 {
+	// Shows the screen of the latest frame; key presses are handed to
+	// the key callback, which forwards them to the keyboard.
 	class ScreenWindow : public winui::CharacterWindow
 	{
 		public:
-		typedef lib::Property<bool> int_t;
+		typedef std::function<void(uint, bool)> key_fn;
 
 		public:
-			ScreenWindow(Screen&, Keyboard&);
-			int_t int60fps( ) { return int_; }
+			ScreenWindow(Frames&);
+			void setKeyCallback(key_fn f) { key_ = f; }
 		private:
 			void onUpdate(uint);
 			void onRender( );
 			void onEvent(const SDL_Event&);
 
 		private:
-			Screen *screen_;
-			Keyboard *keyboard_;
-			uint fps_;
-			int_t int_;
+			Frames *frames_;
+			key_fn key_;
 	};
 }
 
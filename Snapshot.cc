@@ -0,0 +1,152 @@
+#include <fstream>
+#include <iterator>
+
+#include "Snapshot.h"
+#include "lib.h"
+
+#define MXT_MAX_LITERAL 0x80
+#define MXT_MIN_RUN 3
+#define MXT_MAX_RUN (0x7F + MXT_MIN_RUN)
+
+namespace z80 {
+
+Snapshot::Snapshot(void)
+	: pos_(0)
+{
+	write32(MAGIC);
+	write32(VERSION);
+}
+
+// A control byte below 0x80 is followed by that many + 1 literal bytes;
+// one above repeats the next byte (control - 0x80 + 3) times.
+void Snapshot::write(const uint8_t *p, uint n)
+{
+	uint i = 0;
+
+	while(i < n)
+	{
+		uint r = 1;
+
+		while(i + r < n && r < MXT_MAX_RUN && p[i + r] == p[i]) ++r;
+
+		if(r >= MXT_MIN_RUN)
+		{
+			write8(0x80 + r - MXT_MIN_RUN);
+			write8(p[i]);
+			i += r;
+		}
+		else
+		{
+			uint l = 1;
+
+			// a literal stretch ends where a run starts
+			while(i + l < n && l < MXT_MAX_LITERAL
+				&& !(i + l + 2 < n && p[i + l] == p[i + l + 1] && p[i + l] == p[i + l + 2]))
+			{
+				++l;
+			}
+
+			write8(l - 1);
+			data_.insert(data_.end(), p + i, p + i + l);
+			i += l;
+		}
+	}
+}
+
+uint8_t Snapshot::read8(void)
+{
+	if(pos_ >= data_.size())
+	{
+		throw std::string("Snapshot is truncated!");
+	}
+
+	return data_[pos_++];
+}
+
+void Snapshot::read(uint8_t *p, uint n)
+{
+	uint i = 0;
+
+	while(i < n)
+	{
+		uint c = read8();
+		uint l = c < 0x80 ? c + 1 : c - 0x80 + MXT_MIN_RUN;
+
+		if(i + l > n)
+		{
+			throw std::string("Snapshot is corrupted!");
+		}
+
+		if(c < 0x80)
+		{
+			for(uint j = 0 ; j < l ; ++j) p[i + j] = read8();
+		}
+		else
+		{
+			uint8_t v = read8();
+
+			for(uint j = 0 ; j < l ; ++j) p[i + j] = v;
+		}
+
+		i += l;
+	}
+}
+
+// Reads the length of a list whose entries take up at least the given
+// number of bytes each, and checks that they can fit in what is left.
+uint32_t Snapshot::readCount(uint w)
+{
+	uint32_t n = read32();
+
+	if(n > (data_.size() - pos_) / w)
+	{
+		throw std::string("Snapshot is corrupted!");
+	}
+
+	return n;
+}
+
+// Positions the snapshot right after its header.
+void Snapshot::rewind(void)
+{
+	pos_ = 0;
+
+	if(read32() != MAGIC)
+	{
+		throw std::string("Not a snapshot!");
+	}
+
+	uint32_t v = read32();
+
+	if(v != VERSION)
+	{
+		throw lib::stringf("Unsupported snapshot version %u (expected %u)!", v, VERSION);
+	}
+}
+
+void Snapshot::save(const std::string& fn) const
+{
+	std::ofstream out(fn, std::ios::binary);
+
+	if(!out.write((const char *) data_.data(), data_.size()))
+	{
+		throw std::string("Can't write snapshot '" + fn + "'!");
+	}
+}
+
+void Snapshot::load(const std::string& fn)
+{
+	std::ifstream in(fn, std::ios::binary);
+
+	if(!in)
+	{
+		throw std::string("Can't open snapshot '" + fn + "'!");
+	}
+
+	data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+	rewind();
+}
+
+}
+
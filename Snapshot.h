@@ -0,0 +1,47 @@
+#ifndef Z80_SNAPSHOT_H
+#define Z80_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// A versioned, in-memory image of a machine that every component
+	// writes itself into in turn and later reads itself back from, in the
+	// same order. Larger blocks (RAM, VRAM) are run length encoded, which
+	// keeps a snapshot of a freshly booted machine at a few KiB.
+	class Snapshot
+	{
+		public:
+			static const uint32_t MAGIC = 0x5338305A; // "Z80S"
+			static const uint32_t VERSION = 1;
+
+		public:
+			Snapshot( );
+			void write8(uint8_t v) { data_.push_back(v); }
+			void write16(uint16_t v) { write8(v & 0xFF); write8(v >> 8); }
+			void write32(uint32_t v) { write16(v & 0xFFFF); write16(v >> 16); }
+			void write64(uint64_t v) { write32(v & 0xFFFFFFFF); write32(v >> 32); }
+			void write(const uint8_t *, uint);
+			uint8_t read8( );
+			uint16_t read16( ) { uint16_t v = read8(); return v | (read8() << 8); }
+			uint32_t read32( ) { uint32_t v = read16(); return v | ((uint32_t) read16() << 16); }
+			uint64_t read64( ) { uint64_t v = read32(); return v | ((uint64_t) read32() << 32); }
+			void read(uint8_t *, uint);
+			uint32_t readCount(uint = 1);
+			void rewind( );
+			bool isAtEnd( ) const { return pos_ == data_.size(); }
+			size_t size( ) const { return data_.size(); }
+			void save(const std::string&) const;
+			void load(const std::string&);
+		private:
+			std::vector<uint8_t> data_;
+			size_t pos_;
+	};
+}
+
+#endif
+
@@ -8,6 +8,20 @@ void StatusPort::reset(void)
 	idRead_ = 0;
 }
 
+void StatusPort::save(Snapshot& s) const
+{
+	s.write32(queue_.size());
+	for(uint8_t id : queue_) s.write8(id);
+	s.write32(idRead_);
+}
+
+void StatusPort::restore(Snapshot& s)
+{
+	queue_.resize(s.readCount());
+	for(uint8_t& id : queue_) id = s.read8();
+	idRead_ = s.read32();
+}
+
 void StatusPort::write(uint8_t port, uint8_t data)
 {
 }
@@ -5,6 +5,7 @@
 
 #include "Peripheral.h"
 #include "Property.h"
+#include "Snapshot.h"
 
 namespace z80
 {
@@ -22,6 +23,8 @@ namespace z80
 			void registerInt(uint8_t, int_t);
 			void onInt(int_fn f) { onInt_ = f; }
 			void reset( );
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
 		private:
 			std::deque<uint8_t> queue_;
 			int_fn onInt_;
@@ -5,7 +5,7 @@
 
 #define WIN_TITLE "Z80 Status"
 #define WIN_W 41
-#define WIN_H 14
+#define WIN_H 15
 
 #define CHARSET_PATH "charset.bmp"
 #define CHAR_W 8
@@ -47,6 +47,7 @@
 // |IX | $XXXX (YYYYY) | IY | $XXXX (YYYYY)|
 // +---------------------------------------+
 // | @$XXXX: INSTRUCTION                   |
+// | X.XXX MHz [MODE]                      |
 // +---------------------------------------+
 // |Flags  | S | Z |   | H |P/V|   | N | C |
 // +---------------------------------------+
@@ -62,9 +63,10 @@ using winui::Color;
 using winui::CharacterWindow;
 using winui::Image;
 
-StatusWindow::StatusWindow(Z80& cpu)
+StatusWindow::StatusWindow(Frames& frames, Disassembly& disasm)
 	: CharacterWindow(WIN_TITLE, Position::CENTER(), Dimension(WIN_W, WIN_H), Image(CHARSET_PATH), Dimension(CHAR_W, CHAR_H), CHAR_COLORSPACE)
-	, cpu_(&cpu)
+	, frames_(&frames)
+	, disasm_(&disasm)
 {
 	setDefaultColor(Color::WHITE());
 }
@@ -77,6 +79,8 @@ void StatusWindow::onRender(void)
 {
 #define ADD(x) screen.push_back(x)
 	std::vector<uint> screen;
+	const Frames::Frame& f(frames_->front());
+	const Z80& cpu(f.cpu);
 
 	auto printS = [&screen](const std::string& s, uint min)
 	{
@@ -112,51 +116,51 @@ void StatusWindow::onRender(void)
 	ADD(CHAR_H_LD);
 
 	ADD(CHAR_H_UD);
-	printR("PC", cpu_->getPC());
+	printR("PC", cpu.getPC());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("SP", cpu_->getSP());
+	printR("SP", cpu.getSP());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_UD);
-	printR("AF", cpu_->getAF());
+	printR("AF", cpu.getAF());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("AF'", cpu_->getAFp());
+	printR("AF'", cpu.getAFp());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_UD);
-	printR("BC", cpu_->getBC());
+	printR("BC", cpu.getBC());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("BC'", cpu_->getBCp());
+	printR("BC'", cpu.getBCp());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_UD);
-	printR("DE", cpu_->getDE());
+	printR("DE", cpu.getDE());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("DE'", cpu_->getDEp());
+	printR("DE'", cpu.getDEp());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_UD);
-	printR("HL", cpu_->getHL());
+	printR("HL", cpu.getHL());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("HL'", cpu_->getHLp());
+	printR("HL'", cpu.getHLp());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_UD);
-	printR("IX", cpu_->getIX());
+	printR("IX", cpu.getIX());
 	ADD(' ');
 	ADD(CHAR_S_UD);
 	ADD(' ');
-	printR("IY", cpu_->getIY());
+	printR("IY", cpu.getIY());
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_RUD);
@@ -170,7 +174,11 @@ void StatusWindow::onRender(void)
 	ADD(CHAR_H_LUD);
 
 	ADD(CHAR_H_UD);
-	printS(lib::stringf(" @$%04X [0x%02X] %s", cpu_->getPC(), cpu_->RAM(cpu_->getPC()), cpu_->disassemble(cpu_->getPC()).c_str()), WIN_W-2);
+	printS(lib::stringf(" @$%04X [0x%02X] %s", cpu.getPC(), cpu.peek(cpu.getPC()), disasm_->get(cpu, cpu.getPC()).text), WIN_W-2);
+	ADD(CHAR_H_UD);
+
+	ADD(CHAR_H_UD);
+	printS(lib::stringf(" %.3f MHz [%s]", f.mhz, f.speed.c_str()), WIN_W-2);
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_RUD);
@@ -214,21 +222,21 @@ void StatusWindow::onRender(void)
 	ADD(CHAR_H_UD);
 	printS("", 7);
 	ADD(CHAR_H_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagS()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagS()), 3);
 	ADD(CHAR_S_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagZ()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagZ()), 3);
 	ADD(CHAR_S_UD);
 	printS(lib::stringf(" %d ", 0), 3);
 	ADD(CHAR_S_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagH()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagH()), 3);
 	ADD(CHAR_S_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagPV()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagPV()), 3);
 	ADD(CHAR_S_UD);
 	printS(lib::stringf(" %d ", 0), 3);
 	ADD(CHAR_S_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagN()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagN()), 3);
 	ADD(CHAR_S_UD);
-	printS(lib::stringf(" %d ", cpu_->getFlagC()), 3);
+	printS(lib::stringf(" %d ", cpu.getFlagC()), 3);
 	ADD(CHAR_H_UD);
 
 	ADD(CHAR_H_RU);
@@ -1,7 +1,8 @@
 #ifndef Z80_STATUSWINDOW_H
 #define Z80_STATUSWINDOW_H
 
-#include "Z80.h"
+#include "Frames.h"
+#include "Disassembly.h"
 #include "CharacterWindow.h"
 #include "Image.h"
 
@@ -10,14 +11,15 @@ namespace z80
 	class StatusWindow : public winui::CharacterWindow
 	{
 		public:
-			StatusWindow(Z80&);
+			StatusWindow(Frames&, Disassembly&);
 		private:
 			void onUpdate(uint);
 			void onRender( );
 			void onEvent(const SDL_Event&);
 
 		private:
-			Z80 *cpu_;
+			Frames *frames_;
+			Disassembly *disasm_;
 	};
 }
 
@@ -0,0 +1,62 @@
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include "Symbols.h"
+#include "lib.h"
+
+namespace z80 {
+
+void Symbols::load(const std::string& fn)
+{
+	std::ifstream in(fn);
+
+	if(!in)
+	{
+		throw std::string("Can't open '") + fn + "'!";
+	}
+
+	map_t labels;
+	std::string line;
+	uint n = 0;
+
+	while(std::getline(in, line))
+	{
+		std::istringstream ss(line);
+		std::string addr, name;
+
+		++n;
+
+		if(!(ss >> addr)) continue;
+
+		if(!(ss >> name) || addr.size() < 2 || addr[0] != '$')
+		{
+			throw lib::stringf("Invalid symbol in '%s', line %u!", fn.c_str(), n);
+		}
+
+		labels[strtoul(addr.c_str() + 1, nullptr, 16) & 0xFFFF] = name;
+	}
+
+	labels_.swap(labels);
+}
+
+// Returns false if there is no label at or below the address.
+bool Symbols::getRoutine(uint16_t a, uint16_t& start, std::string& name) const
+{
+	auto i = labels_.upper_bound(a);
+
+	if(i == labels_.begin())
+	{
+		return false;
+	}
+
+	--i;
+
+	start = i->first;
+	name = i->second;
+
+	return true;
+}
+
+}
+
@@ -0,0 +1,49 @@
+#ifndef Z80_SYMBOLS_H
+#define Z80_SYMBOLS_H
+
+#include <string>
+#include <map>
+#include <stdint.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// The labels the assembler writes next to a binary ("$ADDR name" per
+	// line). An address belongs to the routine of the closest label at or
+	// below it.
+	class Symbols
+	{
+		public:
+			typedef std::map<uint16_t, std::string> map_t;
+
+		public:
+			void load(const std::string&);
+			void clear( ) { labels_.clear(); }
+			bool empty( ) const { return labels_.empty(); }
+			uint size( ) const { return labels_.size(); }
+			bool getRoutine(uint16_t, uint16_t&, std::string&) const;
+			const map_t& getLabels( ) const { return labels_; }
+			static std::string getPath(const std::string&);
+		private:
+			map_t labels_;
+	};
+
+	// The name of the symbol file that goes with a binary. Defined here so
+	// that the assembler, which writes it, can share it.
+	inline std::string Symbols::getPath(const std::string& fn)
+	{
+		std::string sym(fn);
+		size_t dot = sym.find_last_of('.');
+
+		if(dot != std::string::npos && sym.find_first_of("/\\", dot) == std::string::npos)
+		{
+			sym.erase(dot);
+		}
+
+		return sym + ".sym";
+	}
+}
+
+#endif
+
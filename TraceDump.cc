@@ -0,0 +1,99 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <string>
+
+#include "Tracer.h"
+#include "Disassemble.h"
+#include "lib.h"
+
+#define MXT_USAGE "usage: %s TRACE [FIRST [COUNT]]"
+
+using namespace z80;
+
+namespace
+{
+	uint64_t number(const char *s)
+	{
+		char *e = nullptr;
+		uint64_t v = strtoull(s, &e, 0);
+
+		if(!*s || *e)
+		{
+			throw lib::stringf("Invalid number '%s'!", s);
+		}
+
+		return v;
+	}
+
+	void print(std::ostream& os, const Tracer::Record& r)
+	{
+		Instruction ins = disassemble(r.op);
+		std::string bytes;
+
+		for(uint i = 0 ; i < ins.size && i < 4 ; ++i)
+		{
+			bytes += lib::stringf("%02X ", r.op[i]);
+		}
+
+		os << lib::stringf("%12llu %04X  %-12s%-20s AF=%04X BC=%04X DE=%04X HL=%04X IX=%04X IY=%04X SP=%04X",
+			(unsigned long long) r.cycles, r.PC, bytes.c_str(),
+			(r.flags & Tracer::FLAG_INTERRUPT) ? "<interrupt>" : ins.literal.c_str(),
+			r.AF, r.BC, r.DE, r.HL, r.IX, r.IY, r.SP);
+
+		for(uint i = 0 ; i < r.accesses && i < Tracer::ACCESSES ; ++i)
+		{
+			const Tracer::Access& a(r.access[i]);
+
+			os << lib::stringf(" %c[%04X]=%02X", a.write ? 'W' : 'R', a.addr, a.value);
+		}
+
+		if(r.accesses > Tracer::ACCESSES)
+		{
+			os << lib::stringf(" (+%u)", r.accesses - Tracer::ACCESSES);
+		}
+
+		os << "\n";
+	}
+}
+
+// Prints a trace written by a core built with Z80_TRACE, one
+// disassembled instruction per line.
+int main(int argc, char *argv[])
+try
+{
+	if(argc < 2 || argc > 4)
+	{
+		throw lib::stringf(MXT_USAGE, argv[0]);
+	}
+
+	uint64_t first = argc > 2 ? number(argv[2]) : 0;
+	uint64_t count = argc > 3 ? number(argv[3]) : -1;
+
+	std::ifstream in(argv[1], std::ios::binary);
+
+	if(!in)
+	{
+		throw std::string("Can't open '") + argv[1] + "'!";
+	}
+
+	Tracer::readHeader(in);
+
+	in.seekg(first * sizeof(Tracer::Record), std::ios::cur);
+
+	Tracer::Record r;
+
+	while(count-- && in.read((char *) &r, sizeof(r)))
+	{
+		print(std::cout, r);
+	}
+
+	return 0;
+}
+catch(const std::string& e)
+{
+	std::cerr << e << std::endl;
+
+	return 1;
+}
+
@@ -0,0 +1,163 @@
+#include <string>
+
+#include "Tracer.h"
+#include "lib.h"
+
+namespace z80 {
+
+static_assert(sizeof(Tracer::Record) == 48, "Trace records must keep their size!");
+
+namespace
+{
+	void write32(std::ostream& os, uint32_t v)
+	{
+		char b[4] = { (char) (v & 0xFF), (char) ((v >> 8) & 0xFF), (char) ((v >> 16) & 0xFF), (char) (v >> 24) };
+
+		os.write(b, sizeof(b));
+	}
+
+	uint32_t read32(std::istream& is)
+	{
+		uint8_t b[4] = { 0, 0, 0, 0 };
+
+		is.read((char *) b, sizeof(b));
+
+		return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t) b[3] << 24);
+	}
+}
+
+Tracer::Tracer(Z80& cpu, const std::string& fn)
+	: cpu_(&cpu)
+	, buf_(BUFFER)
+	, pos_(0)
+	, records_(0)
+	, free_(BUFFERS - 1, std::vector<Record>(BUFFER))
+	, done_(false)
+{
+	if(!Z80::TRACING)
+	{
+		throw std::string("This build can't trace, rebuild it with Z80_TRACE!");
+	}
+
+	out_.open(fn, std::ios::binary);
+
+	if(!out_)
+	{
+		throw std::string("Can't open '") + fn + "'!";
+	}
+
+	write32(out_, MAGIC);
+	write32(out_, VERSION);
+	write32(out_, sizeof(Record));
+
+	thread_ = std::thread([this]( ) { writer(); });
+
+	cpu_->setTracer(this);
+}
+
+// Whatever is left in the buffers still gets written.
+Tracer::~Tracer(void)
+{
+	cpu_->setTracer(nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+
+		buf_.resize(pos_);
+		full_.push_back(std::move(buf_));
+		done_ = true;
+	}
+
+	cond_.notify_all();
+	thread_.join();
+}
+
+// Blocks until everything recorded so far is on disk.
+void Tracer::flush(void)
+{
+	swap();
+
+	std::unique_lock<std::mutex> lock(mtx_);
+
+	cond_.wait(lock, [this]( ) { return full_.empty() && free_.size() + 1 == BUFFERS; });
+
+	out_.flush();
+}
+
+// Throws if the file couldn't be read or isn't a trace of this version.
+void Tracer::readHeader(std::istream& is)
+{
+	uint32_t magic = read32(is);
+	uint32_t version = read32(is);
+	uint32_t size = read32(is);
+
+	if(!is || magic != MAGIC)
+	{
+		throw std::string("Not a trace file!");
+	}
+
+	if(version != VERSION || size != sizeof(Record))
+	{
+		throw lib::stringf("Unsupported trace version %u!", version);
+	}
+}
+
+// Hands the current buffer to the writer and waits for an empty one.
+void Tracer::swap(void)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+
+	buf_.resize(pos_);
+	records_ += pos_;
+	full_.push_back(std::move(buf_));
+	cond_.notify_all();
+
+	cond_.wait(lock, [this]( ) { return !free_.empty(); });
+
+	buf_ = std::move(free_.back());
+	free_.pop_back();
+	buf_.resize(BUFFER);
+	pos_ = 0;
+
+	if(!error_.empty())
+	{
+		throw error_;
+	}
+}
+
+void Tracer::writer(void)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+
+	while(true)
+	{
+		cond_.wait(lock, [this]( ) { return done_ || !full_.empty(); });
+
+		if(full_.empty())
+		{
+			break;
+		}
+
+		std::vector<Record> b(std::move(full_.front()));
+
+		full_.pop_front();
+		lock.unlock();
+
+		out_.write((const char *) b.data(), b.size() * sizeof(Record));
+
+		bool ok = static_cast<bool>(out_);
+
+		lock.lock();
+
+		if(!ok && error_.empty())
+		{
+			error_ = "Failed to write the trace!";
+		}
+
+		free_.push_back(std::move(b));
+		cond_.notify_all();
+	}
+}
+
+}
+
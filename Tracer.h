@@ -0,0 +1,140 @@
+#ifndef Z80_TRACER_H
+#define Z80_TRACER_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+#include "Z80.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Records every instruction a cpu executes into a file of fixed size
+	// records: the registers before the instruction, its opcode bytes and
+	// the first few memory accesses it made (opcode and operand fetches
+	// excluded). Records are collected in large buffers that a background
+	// thread writes out, so the cpu only blocks once the writer fell
+	// behind by all of them.
+	// The hook only exists in a core built with Z80_TRACE; every other
+	// build pays nothing for it.
+	class Tracer
+	{
+		public:
+			static const uint32_t MAGIC = 0x5438305A; // "Z80T"
+			static const uint32_t VERSION = 1;
+			static const uint ACCESSES = 4;
+			static const size_t BUFFER = 1 << 16;
+			static const uint BUFFERS = 4;
+
+			static const uint8_t FLAG_INTERRUPT = 0x01;
+			static const uint8_t FLAG_HALTED = 0x02;
+			static const uint8_t FLAG_IFF = 0x04;
+
+			struct Access
+			{
+				uint16_t addr;
+				uint8_t value;
+				uint8_t write;
+			};
+
+			// Written as is; the format is little-endian.
+			struct Record
+			{
+				uint64_t cycles;
+				uint16_t PC, AF, BC, DE, HL, IX, IY, SP;
+				uint8_t op[4];
+				uint8_t flags;
+				uint8_t accesses;
+				uint16_t reserved;
+				Access access[ACCESSES];
+			};
+
+		public:
+			Tracer(Z80&, const std::string&);
+			~Tracer( );
+			inline void step(const Z80&);
+			inline void access(uint16_t, uint8_t, bool);
+			void flush( );
+			uint64_t getRecords( ) const { return records_ + pos_; }
+			static void readHeader(std::istream&);
+		private:
+			void swap( );
+			void writer( );
+
+		private:
+			Z80 *cpu_;
+			std::ofstream out_;
+			std::vector<Record> buf_;
+			size_t pos_;
+			uint64_t records_;
+			std::deque<std::vector<Record>> full_;
+			std::vector<std::vector<Record>> free_;
+			std::mutex mtx_;
+			std::condition_variable cond_;
+			bool done_;
+			std::string error_;
+			std::thread thread_;
+	};
+
+	void Tracer::step(const Z80& cpu)
+	{
+		if(pos_ == buf_.size())
+		{
+			swap();
+		}
+
+		Record& r(buf_[pos_++]);
+		Z80::Registers regs(cpu.getRegisters());
+
+		r.cycles = regs.cycles;
+		r.PC = regs.PC;
+		r.AF = regs.AF;
+		r.BC = regs.BC;
+		r.DE = regs.DE;
+		r.HL = regs.HL;
+		r.IX = regs.IX;
+		r.IY = regs.IY;
+		r.SP = regs.SP;
+
+		for(uint i = 0 ; i < 4 ; ++i)
+		{
+			r.op[i] = cpu.peek(regs.PC + i);
+		}
+
+		r.flags = (regs.iff && regs.interrupted ? FLAG_INTERRUPT : 0) | (regs.halted ? FLAG_HALTED : 0) | (regs.iff ? FLAG_IFF : 0);
+		r.accesses = 0;
+		r.reserved = 0;
+	}
+
+	// Accesses past the first few are only counted.
+	void Tracer::access(uint16_t a, uint8_t v, bool w)
+	{
+		if(!pos_)
+		{
+			return;
+		}
+
+		Record& r(buf_[pos_ - 1]);
+
+		if(r.accesses < ACCESSES)
+		{
+			r.access[r.accesses] = Access { a, v, w };
+		}
+
+		if(r.accesses < 0xFF)
+		{
+			++r.accesses;
+		}
+	}
+}
+
+#endif
+
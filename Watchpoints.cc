@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <string>
+
+#include "Watchpoints.h"
+
+namespace z80 {
+
+Watchpoints::Watchpoints(void)
+	: id_(0)
+	, hit_(false)
+{
+	update();
+}
+
+// Watches the addresses (or ports) 'from' through 'to' for accesses of
+// mode 'm' for which 'e' holds. Returns an id to remove it by.
+uint Watchpoints::add(bool port, uint16_t from, uint16_t to, uint m, const Expression& e)
+{
+	if(from > to || (port && to > 0xFF))
+	{
+		throw std::string("Invalid watch range!");
+	}
+
+	if(!(m & ACCESS))
+	{
+		throw std::string("Invalid watch mode!");
+	}
+
+	watches_.push_back(Watch { ++id_, port, from, to, m & ACCESS, e });
+	update();
+
+	return id_;
+}
+
+bool Watchpoints::remove(uint id)
+{
+	auto i = std::find_if(watches_.begin(), watches_.end(), [id](const Watch& w) { return w.id == id; });
+
+	if(i == watches_.end())
+	{
+		return false;
+	}
+
+	watches_.erase(i);
+	update();
+
+	return true;
+}
+
+void Watchpoints::clear(void)
+{
+	watches_.clear();
+	hit_ = false;
+	update();
+}
+
+// The slow path, for accesses to watched pages.
+void Watchpoints::check(const Z80& cpu, bool port, uint16_t a, uint8_t v, uint m)
+{
+	if(hit_)
+	{
+		return;
+	}
+
+	for(const Watch& w : watches_)
+	{
+		if(w.port == port && (w.mode & m) && a >= w.from && a <= w.to && w.expr.eval(cpu, a, v))
+		{
+			last_ = Hit { w.id, a, v, port, m == WRITE };
+			hit_ = true;
+
+			return;
+		}
+	}
+}
+
+void Watchpoints::update(void)
+{
+	std::fill(std::begin(pages_), std::end(pages_), 0);
+	std::fill(std::begin(ports_), std::end(ports_), 0);
+
+	for(const Watch& w : watches_)
+	{
+		uint8_t *flags = w.port ? ports_ : pages_;
+		uint shift = w.port ? 0 : 8;
+
+		for(uint i = w.from >> shift ; i <= (uint) (w.to >> shift) ; ++i)
+		{
+			flags[i] |= w.mode;
+		}
+	}
+}
+
+}
+
@@ -0,0 +1,69 @@
+#ifndef Z80_WATCHPOINTS_H
+#define Z80_WATCHPOINTS_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "Expression.h"
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Watchpoints on ranges of memory or ports. Every 256 byte page of
+	// memory and every port carries the modes watched anywhere in it, so
+	// an access the cpu makes to an unwatched page costs it one branch;
+	// only accesses to watched pages get checked against the ranges.
+	// A watchpoint with a condition only hits while it holds. The first
+	// hit is latched until the cpu stops for it.
+	class Watchpoints
+	{
+		public:
+			static const uint READ = 1;
+			static const uint WRITE = 2;
+			static const uint ACCESS = READ | WRITE;
+
+			struct Watch
+			{
+				uint id;
+				bool port;
+				uint16_t from, to;
+				uint mode;
+				Expression expr;
+			};
+
+			struct Hit
+			{
+				uint id;
+				uint16_t addr;
+				uint8_t value;
+				bool port, write;
+			};
+
+		public:
+			Watchpoints( );
+			uint add(bool, uint16_t, uint16_t, uint, const Expression& = Expression());
+			bool remove(uint);
+			void clear( );
+			bool any( ) const { return !watches_.empty(); }
+			const std::vector<Watch>& getWatches( ) const { return watches_; }
+			bool isWatched(uint16_t a, uint m) const { return pages_[a >> 8] & m; }
+			bool isWatchedPort(uint8_t p, uint m) const { return ports_[p] & m; }
+			void check(const Z80&, bool, uint16_t, uint8_t, uint);
+			bool isHit( ) const { return hit_; }
+			const Hit& getHit( ) const { return last_; }
+			void resume( ) { hit_ = false; }
+		private:
+			void update( );
+
+		private:
+			std::vector<Watch> watches_;
+			uint8_t pages_[0x100], ports_[0x100];
+			uint id_;
+			bool hit_;
+			Hit last_;
+	};
+}
+
+#endif
+
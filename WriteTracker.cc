@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <string>
+
+#include "WriteTracker.h"
+
+namespace z80 {
+
+WriteTracker::WriteTracker(void)
+{
+	std::fill(pages_, pages_ + 0x100, 0);
+}
+
+WriteTracker& WriteTracker::operator=(const WriteTracker&)
+{
+	for(uint i = 0 ; i < MAX_SUBSCRIBERS ; ++i)
+	{
+		subs_[i] = nullptr;
+	}
+
+	std::fill(pages_, pages_ + 0x100, 0);
+
+	return *this;
+}
+
+uint WriteTracker::subscribe(invalidate_fn f)
+{
+	for(uint i = 0 ; i < MAX_SUBSCRIBERS ; ++i)
+	{
+		if(!subs_[i])
+		{
+			subs_[i] = f;
+
+			return i;
+		}
+	}
+
+	throw std::string("Too many write tracker subscribers!");
+}
+
+void WriteTracker::unsubscribe(uint id)
+{
+	for(uint i = 0 ; i < 0x100 ; ++i)
+	{
+		unmark(id, i);
+	}
+
+	subs_[id] = nullptr;
+}
+
+// Slow path of a write into a marked page.
+void WriteTracker::write(uint16_t a)
+{
+	uint8_t p = a >> 8;
+
+	for(uint i = 0 ; i < MAX_SUBSCRIBERS ; ++i)
+	{
+		if((pages_[p] & (1 << i)) && !subs_[i](a))
+		{
+			unmark(i, p);
+		}
+	}
+}
+
+}
+
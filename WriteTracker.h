@@ -0,0 +1,42 @@
+#ifndef Z80_WRITETRACKER_H
+#define Z80_WRITETRACKER_H
+
+#include <functional>
+#include <stdint.h>
+
+typedef unsigned uint;
+
+namespace z80
+{
+	// Tracks which 256 byte pages of guest memory hold data that somebody
+	// decoded from it (code blocks, disassembly, ...). Subscribers mark the
+	// pages they depend on and get called for every write into them; a
+	// write to an unmarked page costs the caller a single branch.
+	// A copy starts out without subscribers, like the caches built on it.
+	class WriteTracker
+	{
+		public:
+			// Called with the written address. Returns whether the
+			// subscriber still depends on the page.
+			typedef std::function<bool(uint16_t)> invalidate_fn;
+
+			static const uint MAX_SUBSCRIBERS = 8;
+
+		public:
+			WriteTracker( );
+			WriteTracker(const WriteTracker&) : WriteTracker( ) { }
+			WriteTracker& operator=(const WriteTracker&);
+			uint subscribe(invalidate_fn);
+			void unsubscribe(uint);
+			void mark(uint id, uint8_t page) { pages_[page] |= 1 << id; }
+			void unmark(uint id, uint8_t page) { pages_[page] &= ~(1 << id); }
+			bool isTracked(uint16_t a) const { return pages_[a >> 8]; }
+			void write(uint16_t);
+		private:
+			invalidate_fn subs_[MAX_SUBSCRIBERS];
+			uint8_t pages_[0x100];
+	};
+}
+
+#endif
+
@@ -1,7 +1,15 @@
 #include <stdio.h>
+#include <algorithm>
 
 #include "z80.h"
 #include "Disassemble.h"
+#include "Cycles.h"
+#include "Flags.h"
+#include "Rewind.h"
+#include "Profiler.h"
+#ifdef Z80_TRACE
+#include "Tracer.h"
+#endif
 #include "lib.h"
 
 #define MXT_BUFSIZE 80
@@ -75,19 +83,74 @@ void Z80::printRAM(std::ostream& os, addr_t start, size_t len)
 		{
 			if(j + i * 16 < start) os << "   ";
 			else if(j + i * 16 >= start + len) break;
-			else { snprintf(buf, MXT_BUFSIZE, "%02X ", ram_[j + i * 16]); os << buf; }
+			else { snprintf(buf, MXT_BUFSIZE, "%02X ", mem_.peek(j + i * 16)); os << buf; }
 		}
 
 		os << "\n";
 	}
 }
 
+Z80::Z80(void)
+	: epoch_(0)
+	, dispatch_(DISPATCH)
+	, abort_(false)
+	, native_(0)
+{
+	static bool initialized = false;
+
+	if(!initialized)
+	{
+		initOps();
+		initialized = true;
+	}
+
+	clearPeripherals();
+}
+
 void Z80::reset(void)
 {
 	int_ = false;
 	halted_ = false;
 	PC = 0;
 	IR = 0;
+	cycles_ = 0;
+	events_.align(cycles_);
+	++epoch_;
+}
+
+// Only the cpu's own RAM is part of the snapshot; banks and ROMs mapped
+// in from the outside belong to whoever owns them.
+void Z80::save(Snapshot& s) const
+{
+	const uint16_t *r[] = { &AF, &AFp, &BC, &BCp, &DE, &DEp, &HL, &HLp, &IR, &IX, &IY, &SP, &PC };
+
+	for(const uint16_t *p : r) s.write16(*p);
+
+	s.write8((int_ ? 1 : 0) | (halted_ ? 2 : 0) | (interrupted_ ? 4 : 0));
+	s.write64(cycles_);
+	mem_.save(s);
+}
+
+void Z80::restore(Snapshot& s)
+{
+	uint16_t *r[] = { &AF, &AFp, &BC, &BCp, &DE, &DEp, &HL, &HLp, &IR, &IX, &IY, &SP, &PC };
+
+	for(uint16_t *p : r) *p = s.read16();
+
+	uint8_t f = s.read8();
+
+	int_ = f & 1;
+	halted_ = f & 2;
+	interrupted_ = f & 4;
+	cycles_ = s.read64();
+	events_.align(cycles_);
+
+	for(uint i = 0 ; i < Memory::PAGES ; ++i)
+	{
+		remap(i);
+	}
+
+	mem_.restore(s);
 }
 
 void Z80::loadRAM(addr_t start, const Program& prg)
@@ -97,32 +160,197 @@ void Z80::loadRAM(addr_t start, const Program& prg)
 
 	for(size_t i = 0 ; i < len ; ++i)
 	{
-		ram_[(start + i) % 0x10000] = data[i];
+		invalidate(start + i);
+		mem_.RAM(start + i) = data[i];
 	}
 }
 
+// Maps the whole block of 16 ports 'p' lies in.
 void Z80::registerPeripheral(port_t p, Peripheral& o)
 {
-	periphs_[p >> 4] = &o;
+	registerPeripheral(p & 0xF0, 0x10, o);
+}
+
+void Z80::registerPeripheral(port_t p, uint n, Peripheral& o)
+{
+	if(!n || p + n > 0x100)
+	{
+		throw lib::stringf("Invalid port range $%02X+%u!", p, n);
+	}
+
+	for(uint i = p ; i < p + n ; ++i)
+	{
+		ports_[i].periph = &o;
+		ports_[i].base = p;
+	}
+}
+
+// Either handler may be empty, in which case the access falls through
+// to the peripheral mapped at the port.
+void Z80::registerPort(port_t p, in_fn r, out_fn w)
+{
+	Port& port(ports_[p]);
+
+	if(!port.handler)
+	{
+		handlers_.push_back(Handler());
+		port.handler = handlers_.size();
+	}
+
+	handlers_[port.handler - 1].in = r;
+	handlers_[port.handler - 1].out = w;
+}
+
+void Z80::clearPeripherals(void)
+{
+	for(uint i = 0 ; i < 0x100 ; ++i)
+	{
+		ports_[i] = Port();
+	}
+
+	handlers_.clear();
+}
+
+void Z80::mapRAM(uint page, uint8_t *p)
+{
+	mem_.mapRAM(page, p);
+	remap(page);
+}
+
+void Z80::mapROM(uint page, const uint8_t *p)
+{
+	mem_.mapROM(page, p);
+	remap(page);
+}
+
+void Z80::mapIO(uint page, Memory::read_fn r, Memory::write_fn w)
+{
+	mem_.mapIO(page, r, w);
+	remap(page);
+}
+
+void Z80::unmap(uint page)
+{
+	mem_.unmap(page);
+	remap(page);
+}
+
+// Code decoded from the old contents of the page is stale, just as if
+// every byte of it had been overwritten. A bank switch done by a device
+// in the middle of a block aborts that block like any other write would.
+void Z80::remap(uint page)
+{
+	uint16_t a = page << Memory::PAGE_SHIFT;
+
+	for(uint i = 0 ; i < Memory::PAGE_SIZE ; ++i)
+	{
+		invalidate(a + i);
+	}
+
+	++epoch_;
+}
+
+void Z80::setDispatch(Dispatch d)
+{
+	dispatch_ = d;
+
+	if(d != Dispatch::BLOCK && d != Dispatch::JIT)
+	{
+		flush();
+	}
 }
 
+// Device events fire between instructions, however the cpu is driven.
 void Z80::execute(void)
+{
+	execute(dispatch_);
+	fire();
+}
+
+// Runs the next 'n' instructions a second time, for a Rewind that went
+// back to before them. Anything they could see outside the registers
+// and the RAM bumps the epoch and so ends a stretch Rewind replays, which
+// leaves devices out of it; watchpoints, traces and profiles don't see
+// them again either.
+void Z80::replay(uint n)
+{
+	Watchpoints w;
+	Profiler *p = profile_.p;
+
+	std::swap(w, watches_);
+	profile_.p = nullptr;
+#ifdef Z80_TRACE
+	Tracer *t = tracer_.p;
+
+	tracer_.p = nullptr;
+#endif
+
+	while(n--)
+	{
+		execute(DISPATCH);
+	}
+
+#ifdef Z80_TRACE
+	tracer_.p = t;
+#endif
+	profile_.p = p;
+	std::swap(w, watches_);
+	events_.align(cycles_);
+}
+
+// Executes the next instruction, or a whole compiled block in JIT mode.
+// Returns the number of instructions executed.
+uint Z80::step(void)
+{
+	uint n = (dispatch_ == Dispatch::JIT) ? executeNative(-1, events_.next() - cycles_) : 0;
+
+	if(!n)
+	{
+		execute();
+		n = 1;
+	}
+	else
+	{
+		fire();
+	}
+
+	return n;
+}
+
+void Z80::execute(Dispatch d)
 {
 	bool do_int = int_ && interrupted_;
 
+	// idling in a halt is not worth a step of history
+	if(do_int || !halted_)
+	{
+		if(rewind_.p) rewind_.p->step(*this);
+		if(profile_.p) profile_.p->step(PC, cycles_);
+#ifdef Z80_TRACE
+		if(tracer_.p) tracer_.p->step(*this);
+#endif
+	}
+
 	interrupted_ = false;
 
-	byte_t ins = loadB(PC);
-	uint8_t t8;
-	uint16_t t16;
+	// code running out of a device page is never cached
+	if((d == Dispatch::BLOCK || d == Dispatch::JIT) && !do_int && !halted_ && mem_.isDirect(PC))
+	{
+		executeBlock();
+		return;
+	}
+
+	byte_t ins = mem_.read(PC);
 
 	if(do_int)
 	{
 		ins = 0xFF; // rst38
 		halted_ = false;
+		cycles_ += Cycles::IRQ - Cycles::MAIN[ins];
 	}
 	else if(halted_)
 	{
+		cycles_ += Cycles::MAIN[0x00]; // a halted cpu keeps executing nops
 		return;
 	}
 	else
@@ -130,2280 +358,526 @@ void Z80::execute(void)
 		++PC;
 	}
 
+	cycles_ += Cycles::MAIN[ins];
+
+	if(d == Dispatch::TABLE)
+	{
+		ops_[OPS_MAIN][ins](*this, ins, 0);
+	}
+	else
+	{
+		dispatch(ins);
+	}
+}
+
+// # --------------------------------------------------------------------------- 
+// # Switch dispatch
+
+void Z80::dispatch(byte_t ins)
+{
+	uint8_t t8;
+	uint16_t t16;
+
+#define MXT_CASE(op, ...) case op: { __VA_ARGS__ } break;
 	switch(ins)
 	{
-		case 0x00: // nop
-			break;
-		case 0x01: // ld bc,d16
-			BC = loadW();
-			break;
-		case 0x02: // ld (bc),a
-			storeB(BC, A());
-			break;
-		case 0x03: // inc bc
-			++BC;
-			break;
-		case 0x04: // inc b
-			set_inc_flags(++B());
-			break;
-		case 0x05: // dec b
-			set_dec_flags(--B());
-			break;
-		case 0x06: // ld b,d8
-			B() = loadB();
-			break;
-		case 0x07: // rlca
-			rlca();
-			break;
-		case 0x08: // ex af,af'
-			swap(AF, AFp);
-			break;
-		case 0x09: // add hl,bc
-			addHL(BC);
-			break;
-		case 0x0A: // ld a,(bc)
-			A() = loadB(BC);
-			break;
-		case 0x0B: // dec bc
-			--BC;
-			break;
-		case 0x0C: // inc c
-			set_inc_flags(++C());
-			break;
-		case 0x0D: // dec c
-			set_dec_flags(--C());
-			break;
-		case 0x0E: // ld c,d8
-			C() = loadB();
-			break;
-		case 0x0F: // rrca
-			rrca();
-			break;
-		case 0x10: // djnz d8
-			if(--B()) jr(); else ++PC;
-			break;
-		case 0x11: // ld de,d16
-			DE = loadW();
-			break;
-		case 0x12: // ld (de),d8
-			storeB(DE, A());
-			break;
-		case 0x13: // inc DE
-			++DE;
-			break;
-		case 0x14: // inc d
-			set_inc_flags(++D());
-			break;
-		case 0x15: // dec d
-			set_dec_flags(--D());
-			break;
-		case 0x16: // ld d,d8
-			D() = loadB();
-			break;
-		case 0x17: // rla
-			rla();
-			break;
-		case 0x18: // jr s8
-			jr();
-			break;
-		case 0x19: // add hl,de
-			addHL(DE);
-			break;
-		case 0x1A: // ld a,(de)
-			A() = loadB(DE);
-			break;
-		case 0x1B: // dec de
-			--DE;
-			break;
-		case 0x1C: // inc e
-			set_inc_flags(++E());
-			break;
-		case 0x1D: // dec e
-			set_dec_flags(--E());
-		case 0x1E: // ld e,d8
-			E() = loadB();
-			break;
-		case 0x1F: // rra
-			rra();
-			break;
-		case 0x20: // jr nz,s8
-			if(!(F() & FLAG_Z)) jr(); else ++PC;
-			break;
-		case 0x21: // ld hl,d16
-			HL = loadW();
-			break;
-		case 0x22: // ld (a16),hl
-			storeW(loadW(), HL);
-			break;
-		case 0x23: // inc hl
-			++HL;
-			break;
-		case 0x24: // inc h
-			set_inc_flags(++H());
-			break;
-		case 0x25: // dec h
-			set_dec_flags(--H());
-			break;
-		case 0x26: // ld h,d8
-			H() = loadB();
-			break;
-		case 0x27: // daa
-			daa();
-			break;
-		case 0x28: // jr z,s8
-			if(F() & FLAG_Z) jr(); else ++PC;
-			break;
-		case 0x29: // add hl,hl
-			addHL(HL);
-			break;
-		case 0x2A: // ld hl,(a16)
-			HL = loadW(loadW());
-			break;
-		case 0x2B: // dec hl
-			--HL;
-			break;
-		case 0x2C: // inc l
-			set_inc_flags(++L());
-			break;
-		case 0x2D: // dec l
-			set_dec_flags(--L());
-			break;
-		case 0x2E: // ld l,d8
-			L() = loadB();
-			break;
-		case 0x2F: // cpl
-			A() = ~A();
-			F() |= FLAG_N | FLAG_H;
-			break;
-		case 0x30: // jr nc,s8
-			if(!(F() & FLAG_C)) jr(); else ++PC;
-			break;
-		case 0x31: // ld sp,d16
-			SP = loadW();
-			break;
-		case 0x32: // ld (a16),a
-			storeB(loadW(), A());
-			break;
-		case 0x33: // inc sp
-			++SP;
-			break;
-		case 0x34: // inc (hl)
-			storeB(HL, loadB(HL) + 1);
-			set_inc_flags(loadB(HL));
-			break;
-		case 0x35: // dec (hl)
-			storeB(HL, loadB(HL) - 1);
-			set_dec_flags(loadB(HL));
-			break;
-		case 0x36: // ld (hl),d8
-			storeB(HL, loadB());
-			break;
-		case 0x37: // scf
-			F() |= FLAG_C;
-			F() &= ~FLAG_N & ~FLAG_H;
-			break;
-		case 0x38: // jr c,s8
-			if(F() & FLAG_C) jr(); else ++PC;
-			break;
-		case 0x39: // add hl,sp
-			addHL(SP);
-			break;
-		case 0x3A: // ld a,(a16)
-			A() = loadB(loadW());
-			break;
-		case 0x3B: // dec sp
-			--SP;
-			break;
-		case 0x3C: // inc a
-			set_inc_flags(++A());
-			break;
-		case 0x3D: // dec a
-			set_dec_flags(--A());
-			break;
-		case 0x3E: // ld a,d8
-			A() = loadB();
-			break;
-		case 0x3F: // ccf
-			F() = (F() & FLAG_C) ? ((F() & ~FLAG_C) | FLAG_H) : ((F() | FLAG_C) & ~FLAG_H);
-			F() &= ~FLAG_N;
-			break;
-		case 0x40: // ld b,b
-			B() = B();
-			break;
-		case 0x41: // ld b,c
-			B() = C();
-			break;
-		case 0x42: // ld b,d
-			B() = D();
-			break;
-		case 0x43: // ld b,e
-			B() = E();
-			break;
-		case 0x44: // ld b,h
-			B() = H();
-			break;
-		case 0x45: // ld b,l
-			B() = L();
-			break;
-		case 0x46: // ld b,(hl)
-			B() = loadB(HL);
-			break;
-		case 0x47: // ld b,a
-			B() = A();
-			break;
-		case 0x48: // ld c,b
-			C() = B();
-			break;
-		case 0x49: // ld c,c
-			C() = C();
-			break;
-		case 0x4A: // ld c,d
-			C() = D();
-			break;
-		case 0x4B: // ld c,e
-			C() = E();
-			break;
-		case 0x4C: // ld c,h
-			C() = H();
-			break;
-		case 0x4D: // ld c,l
-			C() = L();
-			break;
-		case 0x4E: // ld c,(hl)
-			C() = loadB(HL);
-			break;
-		case 0x4F: // ld c,a
-			C() = A();
-			break;
-		case 0x50: // ld d,b
-			D() = B();
-			break;
-		case 0x51: // ld d,c
-			D() = C();
-			break;
-		case 0x52: // ld d,d
-			D() = D();
-			break;
-		case 0x53: // ld d,e
-			D() = E();
-			break;
-		case 0x54: // ld d,h
-			D() = H();
-			break;
-		case 0x55: // ld d,l
-			D() = L();
-			break;
-		case 0x56: // ld d,(hl)
-			D() = loadB(HL);
-			break;
-		case 0x57: // ld d,a
-			D() = A();
-			break;
-		case 0x58: // ld e,b
-			E() = B();
-			break;
-		case 0x59: // ld e,c
-			E() = C();
-			break;
-		case 0x5A: // ld e,d
-			E() = D();
-			break;
-		case 0x5B: // ld e,e
-			E() = E();
-			break;
-		case 0x5C: // ld e,h
-			E() = H();
-			break;
-		case 0x5D: // ld e,l
-			E() = L();
-			break;
-		case 0x5E: // ld e,(hl)
-			E() = loadB(HL);
-			break;
-		case 0x5F: // ld e,a
-			E() = A();
-			break;
-		case 0x60: // ld h,b
-			H() = B();
-			break;
-		case 0x61: // ld h,c
-			H() = C();
-			break;
-		case 0x62: // ld h,d
-			H() = D();
-			break;
-		case 0x63: // ld h,e
-			H() = E();
-			break;
-		case 0x64: // ld h,h
-			H() = H();
-			break;
-		case 0x65: // ld h,l
-			H() = L();
-			break;
-		case 0x66: // ld h,(hl)
-			H() = loadB(HL);
-			break;
-		case 0x67: // ld h,a
-			H() = A();
-			break;
-		case 0x68: // ld l,b
-			L() = B();
-			break;
-		case 0x69: // ld l,c
-			L() = C();
-			break;
-		case 0x6A: // ld l,d
-			L() = D();
-			break;
-		case 0x6B: // ld l,e
-			L() = E();
-			break;
-		case 0x6C: // ld l,h
-			L() = H();
-			break;
-		case 0x6D: // ld l,l
-			L() = L();
-			break;
-		case 0x6E: // ld l,(hl)
-			L() = loadB(HL);
-			break;
-		case 0x6F: // ld l,a
-			L() = A();
-			break;
-		case 0x70: // ld (hl),b
-			storeB(HL, B());
-			break;
-		case 0x71: // ld (hl),c
-			storeB(HL, C());
-			break;
-		case 0x72: // ld (hl),d
-			storeB(HL, D());
-			break;
-		case 0x73: // ld (hl),e
-			storeB(HL, E());
-			break;
-		case 0x74: // ld (hl),h
-			storeB(HL, H());
-			break;
-		case 0x75: // ld (hl),l
-			storeB(HL, L());
-			break;
-		case 0x76: // halt
-			halted_ = true;
-			break;
-		case 0x77: // ld (hl),a
-			storeB(HL, A());
-			break;
-		case 0x78: // ld a,b
-			A() = B();
-			break;
-		case 0x79: // ld a,c
-			A() = C();
-			break;
-		case 0x7A: // ld a,d
-			A() = D();
-			break;
-		case 0x7B: // ld a,e
-			A() = E();
-			break;
-		case 0x7C: // ld a,h
-			A() = H();
-			break;
-		case 0x7D: // ld a,l
-			A() = L();
-			break;
-		case 0x7E: // ld a,(hl)
-			A() = loadB(HL);
-			break;
-		case 0x7F: // ld a,a
-			A() = A();
-			break;
-		case 0x80: // add a,b
-			addA(B());
-			break;
-		case 0x81: // add a,c
-			addA(C());
-			break;
-		case 0x82: // add a,d
-			addA(D());
-			break;
-		case 0x83: // add a,e
-			addA(E());
+#define Z80_OP_MAIN MXT_CASE
+#include "Opcodes.h"
+		case 0xCB: // BITS
+			ins = loadB();
+			cycles_ += Cycles::CB[ins];
+			switch(ins)
+			{
+#define Z80_OP_CB MXT_CASE
+#include "Opcodes.h"
+			}
 			break;
-		case 0x84: // add a,h
-			addA(H());
-			break;
-		case 0x85: // add a,l
-			addA(L());
-			break;
-		case 0x86: // add a,(hl)
-			addA(loadB(HL));
-			break;
-		case 0x87: // add a,a
-			addA(A());
-			break;
-		case 0x88: // adc a,b
-			addA(B(), true);
-			break;
-		case 0x89: // adc a,c
-			addA(C(), true);
-			break;
-		case 0x8A: // adc a,d
-			addA(D(), true);
-			break;
-		case 0x8B: // adc a,e
-			addA(E(), true);
-			break;
-		case 0x8C: // adc a,h
-			addA(H(), true);
-			break;
-		case 0x8D: // adc a,l
-			addA(L(), true);
-			break;
-		case 0x8E: // adc a,(hl)
-			addA(loadB(HL), true);
-			break;
-		case 0x8F: // adc a,a
-			addA(A(), true);
-			break;
-		case 0x90: // sub b
-			subA(B());
-			break;
-		case 0x91: // sub c
-			subA(C());
-			break;
-		case 0x92: // sub d
-			subA(D());
-			break;
-		case 0x93: // sub e
-			subA(E());
-			break;
-		case 0x94: // sub h
-			subA(H());
-			break;
-		case 0x95: // sub l
-			subA(L());
-			break;
-		case 0x96: // sub (hl)
-			subA(loadB(HL));
-			break;
-		case 0x97: // sub a
-			subA(A());
-			break;
-		case 0x98: // sbc a,b
-			subA(B(), true);
-			break;
-		case 0x99: // sbc a,c
-			subA(C(), true);
-			break;
-		case 0x9A: // sbc a,d
-			subA(D(), true);
-			break;
-		case 0x9B: // sbc a,e
-			subA(E(), true);
-			break;
-		case 0x9C: // sbc a,h
-			subA(H(), true);
-			break;
-		case 0x9D: // sbc a,l
-			subA(L(), true);
-			break;
-		case 0x9E: // sbc a,(hl)
-			subA(loadB(HL), true);
-			break;
-		case 0x9F: // sbc a,a
-			subA(A(), true);
-			break;
-		case 0xA0: // and b
-			logicA(A() & B(), true);
-			break;
-		case 0xA1: // and c
-			logicA(A() & C(), true);
-			break;
-		case 0xA2: // and d
-			logicA(A() & D(), true);
-			break;
-		case 0xA3: // and e
-			logicA(A() & E(), true);
-			break;
-		case 0xA4: // and h
-			logicA(A() & H(), true);
-			break;
-		case 0xA5: // and l
-			logicA(A() & L(), true);
-			break;
-		case 0xA6: // and (hl)
-			logicA(A() & loadB(HL), true);
-			break;
-		case 0xA7: // and a
-			logicA(A() & A(), true);
-			break;
-		case 0xA8: // xor b
-			logicA(A() ^ B(), false);
-			break;
-		case 0xA9: // xor c
-			logicA(A() ^ C(), false);
-			break;
-		case 0xAA: // xor d
-			logicA(A() ^ D(), false);
-			break;
-		case 0xAB: // xor e
-			logicA(A() ^ E(), false);
-			break;
-		case 0xAC: // xor h
-			logicA(A() ^ H(), false);
-			break;
-		case 0xAD: // xor l
-			logicA(A() ^ L(), false);
-			break;
-		case 0xAE: // xor (hl)
-			logicA(A() ^ loadB(HL), false);
-			break;
-		case 0xAF: // xor a
-			logicA(A() ^ A(), false);
-			break;
-		case 0xB0: // or b
-			logicA(A() | B(), false);
-			break;
-		case 0xB1: // or c
-			logicA(A() | C(), false);
-			break;
-		case 0xB2: // or d
-			logicA(A() | D(), false);
-			break;
-		case 0xB3: // or e
-			logicA(A() | E(), false);
-			break;
-		case 0xB4: // or h
-			logicA(A() | H(), false);
-			break;
-		case 0xB5: // or l
-			logicA(A() | L(), false);
-			break;
-		case 0xB6: // or (hl)
-			logicA(A() | loadB(HL), false);
-			break;
-		case 0xB7: // or a
-			logicA(A() | A(), false);
-			break;
-		case 0xB8: // cp b
-			t8 = A();
-			subA(B());
-			A() = t8;
-			break;
-		case 0xB9: // cp c
-			t8 = A();
-			subA(C());
-			A() = t8;
-			break;
-		case 0xBA: // cp d
-			t8 = A();
-			subA(D());
-			A() = t8;
-			break;
-		case 0xBB: // cp e
-			t8 = A();
-			subA(E());
-			A() = t8;
-			break;
-		case 0xBC: // cp h
-			t8 = A();
-			subA(H());
-			A() = t8;
-			break;
-		case 0xBD: // cp l
-			t8 = A();
-			subA(L());
-			A() = t8;
-			break;
-		case 0xBE: // cp (hl)
-			t8 = A();
-			subA(loadB(HL));
-			A() = t8;
-			break;
-		case 0xBF: // cp a
-			t8 = A();
-			subA(A());
-			A() = t8;
-			break;
-		case 0xC0: // ret nz
-			if(!(F() & FLAG_Z)) ret();
-			break;
-		case 0xC1: // pop bc
-			BC = popW();
-			break;
-		case 0xC2: // jp nz,a16
-			t16 = loadW();
-			if(!(F() & FLAG_Z)) PC = t16;
-			break;
-		case 0xC3: // jp a16
-			PC = loadW();
-			break;
-		case 0xC4: // call nz,a16
-			t16 = loadW();
-			if(!(F() & FLAG_Z)) call(t16);
-			break;
-		case 0xC5: // push bc
-			pushW(BC);
-			break;
-		case 0xC6: // add a,d8
-			addA(loadB());
-			break;
-		case 0xC7: // rst 00h
-			call(0x0000);
-			break;
-		case 0xC8: // ret z
-			if(F() & FLAG_Z) ret();
-			break;
-		case 0xC9: // ret
-			ret();
-			break;
-		case 0xCA: // jp z,a16
-			t16 = loadW();
-			if(F() & FLAG_Z) PC = t16;
-			break;
-		case 0xCB: // BITS
-			switch(ins = loadB())
-			{
-				case 0x00: // rlc b
-					rotate_left(B(), BIT_BIT7);
-					break;
-				case 0x01: // rlc c
-					rotate_left(C(), BIT_BIT7);
-					break;
-				case 0x02: // rlc d
-					rotate_left(D(), BIT_BIT7);
-					break;
-				case 0x03: // rlc e
-					rotate_left(E(), BIT_BIT7);
-					break;
-				case 0x04: // rlc h
-					rotate_left(H(), BIT_BIT7);
-					break;
-				case 0x05: // rlc l
-					rotate_left(L(), BIT_BIT7);
-					break;
-				case 0x06: // rlc (hl)
-					t8 = loadB(HL);
-					rotate_left(t8, BIT_BIT7);
-					storeB(HL, t8);
-					break;
-				case 0x07: // rlc a
-					rotate_left(B(), BIT_BIT7);
-					break;
-				case 0x08: // rrc b
-					rotate_right(B(), BIT_BIT7);
-					break;
-				case 0x09: // rrc c
-					rotate_right(C(), BIT_BIT7);
-					break;
-				case 0x0A: // rrc d
-					rotate_right(D(), BIT_BIT7);
-					break;
-				case 0x0B: // rrc e
-					rotate_right(E(), BIT_BIT7);
-					break;
-				case 0x0C: // rrc h
-					rotate_right(H(), BIT_BIT7);
-					break;
-				case 0x0D: // rrc l
-					rotate_right(L(), BIT_BIT7);
-					break;
-				case 0x0E: // rrc (hl)
-					t8 = loadB(HL);
-					rotate_right(t8, BIT_BIT7);
-					storeB(HL, t8);
-					break;
-				case 0x0F: // rrc a
-					rotate_right(B(), BIT_BIT7);
-					break;
-				case 0x10: // rl b
-					rotate_left(B(), BIT_CARRY);
-					break;
-				case 0x11: // rl c
-					rotate_left(C(), BIT_CARRY);
-					break;
-				case 0x12: // rl d
-					rotate_left(D(), BIT_CARRY);
-					break;
-				case 0x13: // rl e
-					rotate_left(E(), BIT_CARRY);
-					break;
-				case 0x14: // rl h
-					rotate_left(H(), BIT_CARRY);
-					break;
-				case 0x15: // rl l
-					rotate_left(L(), BIT_CARRY);
-					break;
-				case 0x16: // rl (hl)
-					t8 = loadB(HL);
-					rotate_left(t8, BIT_CARRY);
-					storeB(HL, t8);
-					break;
-				case 0x17: // rl a
-					rotate_left(B(), BIT_CARRY);
-					break;
-				case 0x18: // rr b
-					rotate_right(B(), BIT_CARRY);
-					break;
-				case 0x19: // rr c
-					rotate_right(C(), BIT_CARRY);
-					break;
-				case 0x1A: // rr d
-					rotate_right(D(), BIT_CARRY);
-					break;
-				case 0x1B: // rr e
-					rotate_right(E(), BIT_CARRY);
-					break;
-				case 0x1C: // rr h
-					rotate_right(H(), BIT_CARRY);
-					break;
-				case 0x1D: // rr l
-					rotate_right(L(), BIT_CARRY);
-					break;
-				case 0x1E: // rr (hl)
-					t8 = loadB(HL);
-					rotate_right(t8, BIT_CARRY);
-					storeB(HL, t8);
-					break;
-				case 0x1F: // rr a
-					rotate_right(B(), BIT_CARRY);
-					break;
-				case 0x20: // sla b
-					rotate_left(B(), BIT_A);
-					break;
-				case 0x21: // sla c
-					rotate_left(C(), BIT_A);
-					break;
-				case 0x22: // sla d
-					rotate_left(D(), BIT_A);
-					break;
-				case 0x23: // sla e
-					rotate_left(E(), BIT_A);
-					break;
-				case 0x24: // sla h
-					rotate_left(H(), BIT_A);
-					break;
-				case 0x25: // sla l
-					rotate_left(L(), BIT_A);
-					break;
-				case 0x26: // sla (hl)
-					t8 = loadB(HL);
-					rotate_left(t8, BIT_A);
-					storeB(HL, t8);
-					break;
-				case 0x27: // sla a
-					rotate_left(B(), BIT_A);
-					break;
-				case 0x28: // sra b
-					rotate_right(B(), BIT_A);
-					break;
-				case 0x29: // sra c
-					rotate_right(C(), BIT_A);
-					break;
-				case 0x2A: // sra d
-					rotate_right(D(), BIT_A);
-					break;
-				case 0x2B: // sra e
-					rotate_right(E(), BIT_A);
-					break;
-				case 0x2C: // sra h
-					rotate_right(H(), BIT_A);
-					break;
-				case 0x2D: // sra l
-					rotate_right(L(), BIT_A);
-					break;
-				case 0x2E: // sra (hl)
-					t8 = loadB(HL);
-					rotate_right(t8, BIT_A);
-					storeB(HL, t8);
-					break;
-				case 0x2F: // sra a
-					rotate_right(B(), BIT_A);
-					break;
-				case 0x30: // sll b
-					rotate_left(B(), BIT_L);
-					break;
-				case 0x31: // sll c
-					rotate_left(C(), BIT_L);
-					break;
-				case 0x32: // sll d
-					rotate_left(D(), BIT_L);
-					break;
-				case 0x33: // sll e
-					rotate_left(E(), BIT_L);
-					break;
-				case 0x34: // sll h
-					rotate_left(H(), BIT_L);
-					break;
-				case 0x35: // sll l
-					rotate_left(L(), BIT_L);
-					break;
-				case 0x36: // sll (hl)
-					t8 = loadB(HL);
-					rotate_left(t8, BIT_L);
-					storeB(HL, t8);
-					break;
-				case 0x37: // sll a
-					rotate_left(B(), BIT_L);
-					break;
-				case 0x38: // srl b
-					rotate_right(B(), BIT_L);
-					break;
-				case 0x39: // srl c
-					rotate_right(C(), BIT_L);
-					break;
-				case 0x3A: // srl d
-					rotate_right(D(), BIT_L);
-					break;
-				case 0x3B: // srl e
-					rotate_right(E(), BIT_L);
-					break;
-				case 0x3C: // srl h
-					rotate_right(H(), BIT_L);
-					break;
-				case 0x3D: // srl l
-					rotate_right(L(), BIT_L);
-					break;
-				case 0x3E: // srl (hl)
-					t8 = loadB(HL);
-					rotate_right(t8, BIT_L);
-					storeB(HL, t8);
-					break;
-				case 0x3F: // srl a
-					rotate_right(B(), BIT_L);
-					break;
-				case 0x40: // bit 0,b
-					test_bit(B(), 0);
-					break;
-				case 0x41: // bit 0,c
-					test_bit(C(), 0);
-					break;
-				case 0x42: // bit 0,d
-					test_bit(D(), 0);
-					break;
-				case 0x43: // bit 0,e
-					test_bit(E(), 0);
-					break;
-				case 0x44: // bit 0,h
-					test_bit(H(), 0);
-					break;
-				case 0x45: // bit 0,l
-					test_bit(L(), 0);
-					break;
-				case 0x46: // bit 0,(hl)
-					test_bit(loadB(HL), 0);
-					break;
-				case 0x47: // bit 0,a
-					test_bit(A(), 0);
-					break;
-				case 0x48: // bit 1,b
-					test_bit(B(), 1);
-					break;
-				case 0x49: // bit 1,c
-					test_bit(C(), 1);
-					break;
-				case 0x4A: // bit 1,d
-					test_bit(D(), 1);
-					break;
-				case 0x4B: // bit 1,e
-					test_bit(E(), 1);
-					break;
-				case 0x4C: // bit 1,h
-					test_bit(H(), 1);
-					break;
-				case 0x4D: // bit 1,l
-					test_bit(L(), 1);
-					break;
-				case 0x4E: // bit 1,(hl)
-					test_bit(loadB(HL), 1);
-					break;
-				case 0x4F: // bit 1,a
-					test_bit(A(), 1);
-					break;
-				case 0x50: // bit 2,b
-					test_bit(B(), 2);
-					break;
-				case 0x51: // bit 2,c
-					test_bit(C(), 2);
-					break;
-				case 0x52: // bit 2,d
-					test_bit(D(), 2);
-					break;
-				case 0x53: // bit 2,e
-					test_bit(E(), 2);
-					break;
-				case 0x54: // bit 2,h
-					test_bit(H(), 2);
-					break;
-				case 0x55: // bit 2,l
-					test_bit(L(), 2);
-					break;
-				case 0x56: // bit 2,(hl)
-					test_bit(loadB(HL), 2);
-					break;
-				case 0x57: // bit 2,a
-					test_bit(A(), 2);
-					break;
-				case 0x58: // bit 3,b
-					test_bit(B(), 3);
-					break;
-				case 0x59: // bit 3,c
-					test_bit(C(), 3);
-					break;
-				case 0x5A: // bit 3,d
-					test_bit(D(), 3);
-					break;
-				case 0x5B: // bit 3,e
-					test_bit(E(), 3);
-					break;
-				case 0x5C: // bit 3,h
-					test_bit(H(), 3);
-					break;
-				case 0x5D: // bit 3,l
-					test_bit(L(), 3);
-					break;
-				case 0x5E: // bit 3,(hl)
-					test_bit(loadB(HL), 3);
-					break;
-				case 0x5F: // bit 3,a
-					test_bit(A(), 3);
-					break;
-				case 0x60: // bit 4,b
-					test_bit(B(), 4);
-					break;
-				case 0x61: // bit 4,c
-					test_bit(C(), 4);
-					break;
-				case 0x62: // bit 4,d
-					test_bit(D(), 4);
-					break;
-				case 0x63: // bit 4,e
-					test_bit(E(), 4);
-					break;
-				case 0x64: // bit 4,h
-					test_bit(H(), 4);
-					break;
-				case 0x65: // bit 4,l
-					test_bit(L(), 4);
-					break;
-				case 0x66: // bit 4,(hl)
-					test_bit(loadB(HL), 4);
-					break;
-				case 0x67: // bit 4,a
-					test_bit(A(), 4);
-					break;
-				case 0x68: // bit 5,b
-					test_bit(B(), 5);
-					break;
-				case 0x69: // bit 5,c
-					test_bit(C(), 5);
-					break;
-				case 0x6A: // bit 5,d
-					test_bit(D(), 5);
-					break;
-				case 0x6B: // bit 5,e
-					test_bit(E(), 5);
-					break;
-				case 0x6C: // bit 5,h
-					test_bit(H(), 5);
-					break;
-				case 0x6D: // bit 5,l
-					test_bit(L(), 5);
-					break;
-				case 0x6E: // bit 5,(hl)
-					test_bit(loadB(HL), 5);
-					break;
-				case 0x6F: // bit 5,a
-					test_bit(A(), 5);
-					break;
-				case 0x70: // bit 6,b
-					test_bit(B(), 6);
-					break;
-				case 0x71: // bit 6,c
-					test_bit(C(), 6);
-					break;
-				case 0x72: // bit 6,d
-					test_bit(D(), 6);
-					break;
-				case 0x73: // bit 6,e
-					test_bit(E(), 6);
-					break;
-				case 0x74: // bit 6,h
-					test_bit(H(), 6);
-					break;
-				case 0x75: // bit 6,l
-					test_bit(L(), 6);
-					break;
-				case 0x76: // bit 6,(hl)
-					test_bit(loadB(HL), 6);
-					break;
-				case 0x77: // bit 6,a
-					test_bit(A(), 6);
-					break;
-				case 0x78: // bit 7,b
-					test_bit(B(), 7);
-					break;
-				case 0x79: // bit 7,c
-					test_bit(C(), 7);
-					break;
-				case 0x7A: // bit 7,d
-					test_bit(D(), 7);
-					break;
-				case 0x7B: // bit 7,e
-					test_bit(E(), 7);
-					break;
-				case 0x7C: // bit 7,h
-					test_bit(H(), 7);
-					break;
-				case 0x7D: // bit 7,l
-					test_bit(L(), 7);
-					break;
-				case 0x7E: // bit 7,(hl)
-					test_bit(loadB(HL), 7);
-					break;
-				case 0x7F: // bit 7,a
-					test_bit(A(), 7);
-					break;
-				case 0x80: // res 0,b
-					B() &= ~(1 << 0);
-					break;
-				case 0x81: // res 0,c
-					C() &= ~(1 << 0);
-					break;
-				case 0x82: // res 0,d
-					D() &= ~(1 << 0);
-					break;
-				case 0x83: // res 0,e
-					E() &= ~(1 << 0);
-					break;
-				case 0x84: // res 0,h
-					H() &= ~(1 << 0);
-					break;
-				case 0x85: // res 0,l
-					L() &= ~(1 << 0);
-					break;
-				case 0x86: // res 0,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 0);
-					storeB(HL, t8);
-					break;
-				case 0x87: // res 0,a
-					A() &= ~(1 << 0);
-					break;
-				case 0x88: // res 1,b
-					B() &= ~(1 << 1);
-					break;
-				case 0x89: // res 1,c
-					C() &= ~(1 << 1);
-					break;
-				case 0x8A: // res 1,d
-					D() &= ~(1 << 1);
-					break;
-				case 0x8B: // res 1,e
-					E() &= ~(1 << 1);
-					break;
-				case 0x8C: // res 1,h
-					H() &= ~(1 << 1);
-					break;
-				case 0x8D: // res 1,l
-					L() &= ~(1 << 1);
-					break;
-				case 0x8E: // res 1,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 1);
-					storeB(HL, t8);
-					break;
-				case 0x8F: // res 1,a
-					A() &= ~(1 << 1);
-					break;
-				case 0x90: // res 2,b
-					B() &= ~(1 << 2);
-					break;
-				case 0x91: // res 2,c
-					C() &= ~(1 << 2);
-					break;
-				case 0x92: // res 2,d
-					D() &= ~(1 << 2);
-					break;
-				case 0x93: // res 2,e
-					E() &= ~(1 << 2);
-					break;
-				case 0x94: // res 2,h
-					H() &= ~(1 << 2);
-					break;
-				case 0x95: // res 2,l
-					L() &= ~(1 << 2);
-					break;
-				case 0x96: // res 2,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 2);
-					storeB(HL, t8);
-					break;
-				case 0x97: // res 2,a
-					A() &= ~(1 << 2);
-					break;
-				case 0x98: // res 3,b
-					B() &= ~(1 << 3);
-					break;
-				case 0x99: // res 3,c
-					C() &= ~(1 << 3);
-					break;
-				case 0x9A: // res 3,d
-					D() &= ~(1 << 3);
-					break;
-				case 0x9B: // res 3,e
-					E() &= ~(1 << 3);
-					break;
-				case 0x9C: // res 3,h
-					H() &= ~(1 << 3);
-					break;
-				case 0x9D: // res 3,l
-					L() &= ~(1 << 3);
-					break;
-				case 0x9E: // res 3,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 3);
-					storeB(HL, t8);
-					break;
-				case 0x9F: // res 3,a
-					A() &= ~(1 << 3);
-					break;
-				case 0xA0: // res 4,b
-					B() &= ~(1 << 4);
-					break;
-				case 0xA1: // res 4,c
-					C() &= ~(1 << 4);
-					break;
-				case 0xA2: // res 4,d
-					D() &= ~(1 << 4);
-					break;
-				case 0xA3: // res 4,e
-					E() &= ~(1 << 4);
-					break;
-				case 0xA4: // res 4,h
-					H() &= ~(1 << 4);
-					break;
-				case 0xA5: // res 4,l
-					L() &= ~(1 << 4);
-					break;
-				case 0xA6: // res 4,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 4);
-					storeB(HL, t8);
-					break;
-				case 0xA7: // res 4,a
-					A() &= ~(1 << 4);
-					break;
-				case 0xA8: // res 5,b
-					B() &= ~(1 << 5);
-					break;
-				case 0xA9: // res 5,c
-					C() &= ~(1 << 5);
-					break;
-				case 0xAA: // res 5,d
-					D() &= ~(1 << 5);
-					break;
-				case 0xAB: // res 5,e
-					E() &= ~(1 << 5);
-					break;
-				case 0xAC: // res 5,h
-					H() &= ~(1 << 5);
-					break;
-				case 0xAD: // res 5,l
-					L() &= ~(1 << 5);
-					break;
-				case 0xAE: // res 5,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 5);
-					storeB(HL, t8);
-					break;
-				case 0xAF: // res 5,a
-					A() &= ~(1 << 5);
-					break;
-				case 0xB0: // res 6,b
-					B() &= ~(1 << 6);
-					break;
-				case 0xB1: // res 6,c
-					C() &= ~(1 << 6);
-					break;
-				case 0xB2: // res 6,d
-					D() &= ~(1 << 6);
-					break;
-				case 0xB3: // res 6,e
-					E() &= ~(1 << 6);
-					break;
-				case 0xB4: // res 6,h
-					H() &= ~(1 << 6);
-					break;
-				case 0xB5: // res 6,l
-					L() &= ~(1 << 6);
-					break;
-				case 0xB6: // res 6,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 6);
-					storeB(HL, t8);
-					break;
-				case 0xB7: // res 6,a
-					A() &= ~(1 << 6);
-					break;
-				case 0xB8: // res 7,b
-					B() &= ~(1 << 7);
-					break;
-				case 0xB9: // res 7,c
-					C() &= ~(1 << 7);
-					break;
-				case 0xBA: // res 7,d
-					D() &= ~(1 << 7);
-					break;
-				case 0xBB: // res 7,e
-					E() &= ~(1 << 7);
-					break;
-				case 0xBC: // res 7,h
-					H() &= ~(1 << 7);
-					break;
-				case 0xBD: // res 7,l
-					L() &= ~(1 << 7);
-					break;
-				case 0xBE: // res 7,(hl)
-					t8 = loadB(HL);
-					t8 &= ~(1 << 7);
-					storeB(HL, t8);
-					break;
-				case 0xBF: // res 7,a
-					A() &= ~(1 << 7);
-					break;
-				case 0xC0: // set 0,b
-					B() |=  (1 << 0);
-					break;
-				case 0xC1: // set 0,c
-					C() |=  (1 << 0);
-					break;
-				case 0xC2: // set 0,d
-					D() |=  (1 << 0);
-					break;
-				case 0xC3: // set 0,e
-					E() |=  (1 << 0);
-					break;
-				case 0xC4: // set 0,h
-					H() |=  (1 << 0);
-					break;
-				case 0xC5: // set 0,l
-					L() |=  (1 << 0);
-					break;
-				case 0xC6: // set 0,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 0);
-					storeB(HL, t8);
-					break;
-				case 0xC7: // set 0,a
-					A() |=  (1 << 0);
-					break;
-				case 0xC8: // set 1,b
-					B() |=  (1 << 1);
-					break;
-				case 0xC9: // set 1,c
-					C() |=  (1 << 1);
-					break;
-				case 0xCA: // set 1,d
-					D() |=  (1 << 1);
-					break;
-				case 0xCB: // set 1,e
-					E() |=  (1 << 1);
-					break;
-				case 0xCC: // set 1,h
-					H() |=  (1 << 1);
-					break;
-				case 0xCD: // set 1,l
-					L() |=  (1 << 1);
-					break;
-				case 0xCE: // set 1,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 1);
-					storeB(HL, t8);
-					break;
-				case 0xCF: // set 1,a
-					A() |=  (1 << 1);
-					break;
-				case 0xD0: // set 2,b
-					B() |=  (1 << 2);
-					break;
-				case 0xD1: // set 2,c
-					C() |=  (1 << 2);
-					break;
-				case 0xD2: // set 2,d
-					D() |=  (1 << 2);
-					break;
-				case 0xD3: // set 2,e
-					E() |=  (1 << 2);
-					break;
-				case 0xD4: // set 2,h
-					H() |=  (1 << 2);
-					break;
-				case 0xD5: // set 2,l
-					L() |=  (1 << 2);
-					break;
-				case 0xD6: // set 2,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 2);
-					storeB(HL, t8);
-					break;
-				case 0xD7: // set 2,a
-					A() |=  (1 << 2);
-					break;
-				case 0xD8: // set 3,b
-					B() |=  (1 << 3);
-					break;
-				case 0xD9: // set 3,c
-					C() |=  (1 << 3);
-					break;
-				case 0xDA: // set 3,d
-					D() |=  (1 << 3);
-					break;
-				case 0xDB: // set 3,e
-					E() |=  (1 << 3);
-					break;
-				case 0xDC: // set 3,h
-					H() |=  (1 << 3);
-					break;
-				case 0xDD: // set 3,l
-					L() |=  (1 << 3);
-					break;
-				case 0xDE: // set 3,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 3);
-					storeB(HL, t8);
-					break;
-				case 0xDF: // set 3,a
-					A() |=  (1 << 3);
-					break;
-				case 0xE0: // set 4,b
-					B() |=  (1 << 4);
-					break;
-				case 0xE1: // set 4,c
-					C() |=  (1 << 4);
-					break;
-				case 0xE2: // set 4,d
-					D() |=  (1 << 4);
-					break;
-				case 0xE3: // set 4,e
-					E() |=  (1 << 4);
-					break;
-				case 0xE4: // set 4,h
-					H() |=  (1 << 4);
-					break;
-				case 0xE5: // set 4,l
-					L() |=  (1 << 4);
-					break;
-				case 0xE6: // set 4,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 4);
-					storeB(HL, t8);
-					break;
-				case 0xE7: // set 4,a
-					A() |=  (1 << 4);
-					break;
-				case 0xE8: // set 5,b
-					B() |=  (1 << 5);
-					break;
-				case 0xE9: // set 5,c
-					C() |=  (1 << 5);
-					break;
-				case 0xEA: // set 5,d
-					D() |=  (1 << 5);
-					break;
-				case 0xEB: // set 5,e
-					E() |=  (1 << 5);
-					break;
-				case 0xEC: // set 5,h
-					H() |=  (1 << 5);
-					break;
-				case 0xED: // set 5,l
-					L() |=  (1 << 5);
-					break;
-				case 0xEE: // set 5,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 5);
-					storeB(HL, t8);
-					break;
-				case 0xEF: // set 5,a
-					A() |=  (1 << 5);
-					break;
-				case 0xF0: // set 6,b
-					B() |=  (1 << 6);
-					break;
-				case 0xF1: // set 6,c
-					C() |=  (1 << 6);
-					break;
-				case 0xF2: // set 6,d
-					D() |=  (1 << 6);
-					break;
-				case 0xF3: // set 6,e
-					E() |=  (1 << 6);
-					break;
-				case 0xF4: // set 6,h
-					H() |=  (1 << 6);
-					break;
-				case 0xF5: // set 6,l
-					L() |=  (1 << 6);
-					break;
-				case 0xF6: // set 6,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 6);
-					storeB(HL, t8);
-					break;
-				case 0xF7: // set 6,a
-					A() |=  (1 << 6);
-					break;
-				case 0xF8: // set 7,b
-					B() |=  (1 << 7);
-					break;
-				case 0xF9: // set 7,c
-					C() |=  (1 << 7);
-					break;
-				case 0xFA: // set 7,d
-					D() |=  (1 << 7);
-					break;
-				case 0xFB: // set 7,e
-					E() |=  (1 << 7);
-					break;
-				case 0xFC: // set 7,h
-					H() |=  (1 << 7);
-					break;
-				case 0xFD: // set 7,l
-					L() |=  (1 << 7);
-					break;
-				case 0xFE: // set 7,(hl)
-					t8 = loadB(HL);
-					t8 |=  (1 << 7);
-					storeB(HL, t8);
-					break;
-				case 0xFF: // set 7,a
-					A() |=  (1 << 7);
-					break;
-			}
-			break;
-		case 0xCC: // call z,a16
-			t16 = loadW();
-			if(F() & FLAG_Z) call(t16);
-			break;
-		case 0xCD: // call a16
-			call(loadW());
-			break;
-		case 0xCE: // adc a,d8
-			addA(loadB(), true);
-			break;
-		case 0xCF: // rst 08h
-			call(0x0008);
-			break;
-		case 0xD0: // ret nc
-			if(!(F() & FLAG_C)) ret();
-			break;
-		case 0xD1: // pop de
-			DE = popW();
-			break;
-		case 0xD2: // jp nc,a16
-			t16 = loadW();
-			if(!(F() & FLAG_C)) PC = t16;
-			break;
-		case 0xD3: // out (d8),a
-			out(loadB(), A());
-			break;
-		case 0xD4: // call nc,a16
-			t16 = loadW();
-			if(!(F() & FLAG_C)) call(t16);
-			break;
-		case 0xD5: // push de
-			pushW(DE);
-			break;
-		case 0xD6: // sub d8
-			subA(loadB());
-			break;
-		case 0xD7: // rst 10h
-			call(0x0010);
-			break;
-		case 0xD8: // ret c
-			if(F() & FLAG_C) ret();
-			break;
-		case 0xD9: // exx
-			swap(BC, BCp);
-			swap(DE, DEp);
-			swap(HL, HLp);
-			break;
-		case 0xDA: // jp c,a16
-			t16 = loadW();
-			if(F() & FLAG_C) PC = t16;
-			break;
-		case 0xDB: // in a,(d8)
-			A() = in(loadB());
-			break;
-		case 0xDC: // call c,a16
-			t16 = loadW();
-			if(F() & FLAG_C) call(t16);
-			break;
-		case 0xDD: // IX
-			switch(ins = loadB())
-			{
-			    case 0x09: // add ix,bc
-			        IX += BC;
-					break;
-				case 0x19: // add ix,de
-				    IX += DE;
-					break;
-				case 0x21: // ld ix,d16
-				    IX = loadW();
-					break;
-				case 0x22: // ld (a16),ix
-				    storeW(loadW(), IX);
-					break;
-				case 0x23: // inc ix
-				    ++IX;
-					break;
-				case 0x29: // add ix,ix
-				    IX += IX;
-					break;
-				case 0x2A: // ld ix,(a16)
-				    IX = loadW(loadW());
-					break;
-				case 0x2B: // dec ix
-				    --IX;
-					break;
-				case 0x34: // inc (ix+s8)
-				    t16 = getOff(IX, loadB());
-					t8 = loadW(t16) + 1;
-					storeB(t16, t8);
-					set_inc_flags(t8);
-					break;
-				case 0x35: // dec (ix+s8)
-				    t16 = getOff(IX, loadB());
-					t8 = loadW(t16) - 1;
-					storeB(t16, t8);
-					set_dec_flags(t8);
-					break;
-				case 0x39: // add ix,sp
-				    IX += SP;
-					break;
-				case 0x46: // ld b,(ix+s8)
-				    B() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x4E: // ld c,(ix+s8)
-				    C() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x56: // ld d,(ix+s8)
-				    D() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x5E: // ld e,(ix+s8)
-				    E() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x66: // ld h,(ix+s8)
-				    H() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x6E: // ld l,(ix+s8)
-				    L() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x70: // ld (ix+s8),b
-				    storeB(getOff(IX, loadB()), B());
-					break;
-				case 0x71: // ld (ix+s8),c
-				    storeB(getOff(IX, loadB()), C());
-					break;
-				case 0x72: // ld (ix+s8),d
-				    storeB(getOff(IX, loadB()), D());
-					break;
-				case 0x73: // ld (ix+s8),e
-				    storeB(getOff(IX, loadB()), E());
-					break;
-				case 0x74: // ld (ix+s8),h
-				    storeB(getOff(IX, loadB()), H());
-					break;
-				case 0x75: // ld (ix+s8),l
-				    storeB(getOff(IX, loadB()), L());
-					break;
-				case 0x77: // ld (ix+s8),a
-				    storeB(getOff(IX, loadB()), A());
-					break;
-				case 0x7E: // ld a,(ix+s8)
-				    A() = loadB(getOff(IX, loadB()));
-					break;
-				case 0x86: // add a,(ix+s8)
-					addA(loadB(getOff(IX, loadB())), false);
-					break;
-				case 0x8E: // adc a,(ix+s8)
-					addA(loadB(getOff(IX, loadB())), true);
-					break;
-				case 0x96: // sub (ix+s8)
-					subA(loadB(getOff(IX, loadB())), false);
-					break;
-				case 0x9E: // sbc a,(ix+s8)
-					subA(loadB(getOff(IX, loadB())), true);
-					break;
-				case 0xA6: // and (ix+s8)
-					logicA(A() & loadB(getOff(IX, loadB())), true);
-					break;
-				case 0xAE: // xor (ix+s8)
-					logicA(A() ^ loadB(getOff(IX, loadB())), false);
-					break;
-				case 0xB6: // or (ix+s8)
-					logicA(A() | loadB(getOff(IX, loadB())), false);
-					break;
-				case 0xBE: // cp (ix+s8)
-					t8 = A();
-					subA(loadB(getOff(IX, loadB())), false);
-					A() = t8;
-					break;
-				case 0xCB: // IX BITS
-					t8 = loadB();
-					switch(ins = loadB())
-					{
-						case 0x06: // rlc (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_left(t8, BIT_BIT7);
-							storeB(t16, t8);
-							break;
-						case 0x0E: // rrc (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_right(t8, BIT_BIT7);
-							storeB(t16, t8);
-							break;
-						case 0x16: // rl (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_left(t8, BIT_CARRY);
-							storeB(t16, t8);
-							break;
-						case 0x1E: // rr (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_right(t8, BIT_CARRY);
-							storeB(t16, t8);
-							break;
-						case 0x26: // sla (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_left(t8, BIT_A);
-							storeB(t16, t8);
-							break;
-						case 0x2E: // sra (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_right(t8, BIT_A);
-							storeB(t16, t8);
-							break;
-						case 0x36: // sll (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_left(t8, BIT_L);
-							storeB(t16, t8);
-							break;
-						case 0x3E: // srl (ix+s8)
-							t8 = loadB(t16 = getOff(IX, t8));
-							rotate_right(t8, BIT_L);
-							storeB(t16, t8);
-							break;
-						case 0x46: // bit 0,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 0);
-							break;
-						case 0x4E: // bit 1,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 1);
-							break;
-						case 0x56: // bit 2,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 2);
-							break;
-						case 0x5E: // bit 3,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 3);
-							break;
-						case 0x66: // bit 4,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 4);
-							break;
-						case 0x6E: // bit 5,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 5);
-							break;
-						case 0x76: // bit 6,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 6);
-							break;
-						case 0x7E: // bit 7,(ix+s8)
-							test_bit(loadB(getOff(IX, t8)), 7);
-							break;
-						case 0x86: // res 0,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 0));
-							break;
-						case 0x8E: // res 1,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 1));
-							break;
-						case 0x96: // res 2,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 2));
-							break;
-						case 0x9E: // res 3,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 3));
-							break;
-						case 0xA6: // res 4,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 4));
-							break;
-						case 0xAE: // res 5,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 5));
-							break;
-						case 0xB6: // res 6,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 6));
-							break;
-						case 0xBE: // res 7,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) & ~(1 << 7));
-							break;
-						case 0xC6: // set 0,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 0));
-							break;
-						case 0xCE: // set 1,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 1));
-							break;
-						case 0xD6: // set 2,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 2));
-							break;
-						case 0xDE: // set 3,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 3));
-							break;
-						case 0xE6: // set 4,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 4));
-							break;
-						case 0xEE: // set 5,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 5));
-							break;
-						case 0xF6: // set 6,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 6));
-							break;
-						case 0xFE: // set 7,(ix+s8)
-							t16 = getOff(IX, t8);
-							storeB(t16, loadB(t16) | (1 << 7));
-							break;
-						default:
-							throw std::string("ERR: unknown IX BIT instruction!");
-					}
-					break;
-				case 0xE1: // pop ix
-				    IX = popW();
-					break;
-				case 0xE3: // ex (sp),ix
-				    SP += 2;
-					t16 = popW();
-					pushW(IX);
-					IX = t16;
-					SP -= 2;
-					break;
-				case 0xE5: // push ix
-				    pushW(IX);
-					break;
-				case 0xE9: // jp (ix)
-				    PC = IX;
-					break;
-				case 0xF9: // ld sp,ix
-				    SP = IX;
-					break;
-			    default:
-					throw lib::stringf("Unknown instruction $DD%02X !", ins);
-			}
-			break;
-		case 0xDE: // sbc a,d8
-			subA(loadB(), true);
-			break;
-		case 0xDF: // rst 18h
-			call(0x0018);
-			break;
-		case 0xE0: // ret po
-			if(!(F() & FLAG_PV)) ret();
-			break;
-		case 0xE1: // pop hl
-			HL = popW();
-			break;
-		case 0xE2: // jp po,a16
-			t16 = loadW();
-			if(!(F() & FLAG_PV)) PC = t16;
-			break;
-		case 0xE3: // ex (sp),hl
-			t16 = loadW(SP);
-			storeW(SP, HL);
-			HL = t16;
-			break;
-		case 0xE4: // call po,a16
-			t16 = loadW();
-			if(!(F() & FLAG_PV)) call(t16);
-			break;
-		case 0xE5: // push hl
-			pushW(HL);
-			break;
-		case 0xE6: // and d8
-			logicA(A() & loadB(), true);
-			break;
-		case 0xE7: // rst 20h
-			call(0x0020);
-			break;
-		case 0xE8: // ret pe
-			if(F() & FLAG_PV) ret();
-			break;
-		case 0xE9: // jp (hl)
-			PC = HL;
-			break;
-		case 0xEA: // jp pe,a16
-			t16 = loadW();
-			if(F() & FLAG_PV) PC = t16;
-			break;
-		case 0xEB: // ex de,hl
-			swap(DE, HL);
-			break;
-		case 0xEC: // call pe,a16
-			t16 = loadW();
-			if(F() & FLAG_PV) call(t16);
+		case 0xDD: // IX
+			ins = loadB();
+			cycles_ += Cycles::XY[ins];
+			switch(ins)
+			{
+#define IXY IX
+#define Z80_OP_XY MXT_CASE
+#include "Opcodes.h"
+				case 0xCB: // IX BITS
+					t8 = loadB();
+					ins = loadB();
+					cycles_ += Cycles::XYCB[ins];
+					switch(ins)
+					{
+#define Z80_OP_XYCB MXT_CASE
+#include "Opcodes.h"
+						default:
+							throw lib::stringf("Unknown instruction $DDCB%02X !", ins);
+					}
+					break;
+#undef IXY
+				default:
+					throw lib::stringf("Unknown instruction $DD%02X !", ins);
+			}
 			break;
 		case 0xED: // EXTD
-			switch(ins = loadB())
+			ins = loadB();
+			cycles_ += Cycles::ED[ins];
+			switch(ins)
 			{
-			    case 0x40: // in b,(c)
-				    set_inc_flags(B() = in(C()));
-				    break;
-				case 0x41: // out (c),b
-				    out(C(), B());
-				    break;
-				case 0x42: // sbc hl,bc
-					subHL(BC, true);
-					break;
-				case 0x43: // ld (a16),bc
-				    storeW(loadW(), BC);
-					break;
-				case 0x48: // in c,(c)
-				    set_inc_flags(C() = in(C()));
-				    break;
-				case 0x49: // out (c),c
-				    out(C(), C());
-				    break;
-				case 0x4A: // adc hl,bc
-					addHL(BC, true);
-					break;
-			    case 0x4B: // ld bc,(a16)
-				    BC = loadW(loadW());
-					break;
-				case 0x50: // in d,(c)
-				    set_inc_flags(D() = in(C()));
-				    break;
-				case 0x51: // out (c),d
-				    out(C(), D());
-				    break;
-				case 0x52: // sbc hl,de
-					subHL(DE, true);
-					break;
-				case 0x53: // ld (a16),de
-				    storeW(loadW(), DE);
-					break;
-				case 0x56: // im 1
-					break;
-				case 0x58: // in e,(c)
-				    set_inc_flags(E() = in(C()));
-				    break;
-				case 0x59: // out (c),e
-				    out(C(), E());
-				    break;
-				case 0x5A: // adc hl,de
-					addHL(DE, true);
-					break;
-				case 0x5B: // ld de,(a16)
-				    DE = loadW(loadW());
-					break;
-				case 0x60: // in h,(c)
-				    set_inc_flags(H() = in(C()));
-					break;
-				case 0x61: // out (c),h
-				    out(C(), H());
-				    break;
-				case 0x62: // sbc hl,hl
-					subHL(HL, true);
-					break;
-				case 0x63: // ld (a16),hl
-				    storeW(loadW(), HL);
-					break;
-				case 0x68: // in l,(c)
-				    set_inc_flags(L() = in(C()));
-				    break;
-				case 0x69: // out (c),l
-				    out(C(), L());
-				    break;
-				case 0x6A: // adc hl,hl
-					addHL(HL, true);
-					break;
-				case 0x6B: // ld hl,(a16)
-				    HL = loadW(loadW());
-					break;
-				case 0x70: // in (c)
-				    set_inc_flags(in(C()));
-				    break;
-				case 0x71: // out (c),0
-				    out(C(), 0);
-				    break;
-				case 0x72: // sbc hl,sp
-					subHL(SP, true);
-					break;
-				case 0x73: // ld (a16),sp
-				    storeW(loadW(), SP);
-					break;
-				case 0x78: // in a,(c)
-				    set_inc_flags(A() = in(C()));
-				    break;
-				case 0x79: // out (c),a
-				    out(C(), A());
-				    break;
-				case 0x7A: // adc hl,sp
-					addHL(SP, true);
-					break;
-				case 0x7B: // ld sp,(a16)
-				    SP = loadW(loadW());
-					break;
+#define Z80_OP_ED MXT_CASE
+#include "Opcodes.h"
 				default:
 					throw lib::stringf("Unknown instruction $ED%02X !", ins);
 			}
-			break;
-		case 0xEE: // xor d8
-			logicA(A() ^ loadB(), false);
-			break;
-		case 0xEF: // rst 28h
-			call(0x0028);
-			break;
-		case 0xF0: // ret p
-			if(!(F() & FLAG_N)) ret();
-			break;
-		case 0xF1: // pop af
-			AF = popW();
-			break;
-		case 0xF2: // jp p,a16
-			t16 = loadW();
-			if(!(F() & FLAG_N)) PC = t16;
-			break;
-		case 0xF3: // di
-			int_ = false;
-			break;
-		case 0xF4: // call p,a16
-			t16 = loadW();
-			if(!(F() & FLAG_N)) call(t16);
-			break;
-		case 0xF5: // push af
-			pushW(AF);
-			break;
-		case 0xF6: // or d8
-			logicA(A() | loadB(), false);
-			break;
-		case 0xF7: // rst 30h
-			call(0x0030);
-			break;
-		case 0xF8: // ret m
-			if(F() & FLAG_N) ret();
-			break;
-		case 0xF9: // ld sp,hl
-			SP = HL;
-			break;
-		case 0xFA: // jp m,a16
-			t16 = loadW();
-			if(F() & FLAG_N) PC = t16;
-			break;
-		case 0xFB: // ei
-			int_ = true;
-			break;
-		case 0xFC: // call m,a16
-			t16 = loadW();
-			if(F() & FLAG_N) call(t16);
-			break;
-		case 0xFD: // IY
-			switch(ins = loadB())
-			{
-			    case 0x09: // add iy,bc
-			        IY += BC;
-					break;
-				case 0x19: // add iy,de
-				    IY += DE;
-					break;
-				case 0x21: // ld iy,d16
-				    IY = loadW();
-					break;
-				case 0x22: // ld (a16),iy
-				    storeW(loadW(), IY);
-					break;
-				case 0x23: // inc iy
-				    ++IY;
-					break;
-				case 0x29: // add iy,iy
-				    IY += IY;
-					break;
-				case 0x2A: // ld iy,(a16)
-				    IY = loadW(loadW());
-					break;
-				case 0x2B: // dec iy
-				    --IY;
-					break;
-				case 0x34: // inc (iy+s8)
-				    t16 = getOff(IY, loadB());
-					t8 = loadW(t16) + 1;
-					storeB(t16, t8);
-					set_inc_flags(t8);
-					break;
-				case 0x35: // dec (iy+s8)
-				    t16 = getOff(IY, loadB());
-					t8 = loadW(t16) - 1;
-					storeB(t16, t8);
-					set_dec_flags(t8);
-					break;
-				case 0x39: // add iy,sp
-				    IY += SP;
-					break;
-				case 0x46: // ld b,(iy+s8)
-				    B() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x4E: // ld c,(iy+s8)
-				    C() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x56: // ld d,(iy+s8)
-				    D() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x5E: // ld e,(iy+s8)
-				    E() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x66: // ld h,(iy+s8)
-				    H() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x6E: // ld l,(iy+s8)
-				    L() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x70: // ld (iy+s8),b
-				    storeB(getOff(IY, loadB()), B());
-					break;
-				case 0x71: // ld (iy+s8),c
-				    storeB(getOff(IY, loadB()), C());
-					break;
-				case 0x72: // ld (iy+s8),d
-				    storeB(getOff(IY, loadB()), D());
-					break;
-				case 0x73: // ld (iy+s8),e
-				    storeB(getOff(IY, loadB()), E());
-					break;
-				case 0x74: // ld (iy+s8),h
-				    storeB(getOff(IY, loadB()), H());
-					break;
-				case 0x75: // ld (iy+s8),l
-				    storeB(getOff(IY, loadB()), L());
-					break;
-				case 0x77: // ld (iy+s8),a
-				    storeB(getOff(IY, loadB()), A());
-					break;
-				case 0x7E: // ld a,(iy+s8)
-				    A() = loadB(getOff(IY, loadB()));
-					break;
-				case 0x86: // add a,(iy+s8)
-					addA(loadB(getOff(IY, loadB())), false);
-					break;
-				case 0x8E: // adc a,(iy+s8)
-					addA(loadB(getOff(IY, loadB())), true);
-					break;
-				case 0x96: // sub (iy+s8)
-					subA(loadB(getOff(IY, loadB())), false);
-					break;
-				case 0x9E: // sbc a,(iy+s8)
-					subA(loadB(getOff(IY, loadB())), true);
-					break;
-				case 0xA6: // and (iy+s8)
-					logicA(A() & loadB(getOff(IY, loadB())), true);
-					break;
-				case 0xAE: // xor (iy+s8)
-					logicA(A() ^ loadB(getOff(IY, loadB())), false);
-					break;
-				case 0xB6: // or (iy+s8)
-					logicA(A() | loadB(getOff(IY, loadB())), false);
-					break;
-				case 0xBE: // cp (iy+s8)
-					t8 = A();
-					subA(loadB(getOff(IY, loadB())), false);
-					A() = t8;
-					break;
+			break;
+		case 0xFD: // IY
+			ins = loadB();
+			cycles_ += Cycles::XY[ins];
+			switch(ins)
+			{
+#define IXY IY
+#define Z80_OP_XY MXT_CASE
+#include "Opcodes.h"
 				case 0xCB: // IY BITS
 					t8 = loadB();
-					switch(ins = loadB())
+					ins = loadB();
+					cycles_ += Cycles::XYCB[ins];
+					switch(ins)
 					{
-						case 0x06: // rlc (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_left(t8, BIT_BIT7);
-							storeB(t16, t8);
-							break;
-						case 0x0E: // rrc (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_right(t8, BIT_BIT7);
-							storeB(t16, t8);
-							break;
-						case 0x16: // rl (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_left(t8, BIT_CARRY);
-							storeB(t16, t8);
-							break;
-						case 0x1E: // rr (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_right(t8, BIT_CARRY);
-							storeB(t16, t8);
-							break;
-						case 0x26: // sla (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_left(t8, BIT_A);
-							storeB(t16, t8);
-							break;
-						case 0x2E: // sra (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_right(t8, BIT_A);
-							storeB(t16, t8);
-							break;
-						case 0x36: // sll (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_left(t8, BIT_L);
-							storeB(t16, t8);
-							break;
-						case 0x3E: // srl (iy+s8)
-							t8 = loadB(t16 = getOff(IY, t8));
-							rotate_right(t8, BIT_L);
-							storeB(t16, t8);
-							break;
-						case 0x46: // bit 0,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 0);
-							break;
-						case 0x4E: // bit 1,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 1);
-							break;
-						case 0x56: // bit 2,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 2);
-							break;
-						case 0x5E: // bit 3,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 3);
-							break;
-						case 0x66: // bit 4,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 4);
-							break;
-						case 0x6E: // bit 5,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 5);
-							break;
-						case 0x76: // bit 6,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 6);
-							break;
-						case 0x7E: // bit 7,(iy+s8)
-							test_bit(loadB(getOff(IY, t8)), 7);
-							break;
-						case 0x86: // res 0,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 0));
-							break;
-						case 0x8E: // res 1,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 1));
-							break;
-						case 0x96: // res 2,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 2));
-							break;
-						case 0x9E: // res 3,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 3));
-							break;
-						case 0xA6: // res 4,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 4));
-							break;
-						case 0xAE: // res 5,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 5));
-							break;
-						case 0xB6: // res 6,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 6));
-							break;
-						case 0xBE: // res 7,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) & ~(1 << 7));
-							break;
-						case 0xC6: // set 0,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 0));
-							break;
-						case 0xCE: // set 1,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 1));
-							break;
-						case 0xD6: // set 2,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 2));
-							break;
-						case 0xDE: // set 3,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 3));
-							break;
-						case 0xE6: // set 4,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 4));
-							break;
-						case 0xEE: // set 5,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 5));
-							break;
-						case 0xF6: // set 6,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 6));
-							break;
-						case 0xFE: // set 7,(iy+s8)
-							t16 = getOff(IY, t8);
-							storeB(t16, loadB(t16) | (1 << 7));
-							break;
+#define Z80_OP_XYCB MXT_CASE
+#include "Opcodes.h"
 						default:
-							throw std::string("ERR: unknown IY BIT instruction!");
+							throw lib::stringf("Unknown instruction $FDCB%02X !", ins);
 					}
 					break;
-				case 0xE1: // pop iy
-				    IY = popW();
-					break;
-				case 0xE3: // ex (sp),iy
-				    SP += 2;
-					t16 = popW();
-					pushW(IY);
-					IY = t16;
-					SP -= 2;
-					break;
-				case 0xE5: // push iy
-				    pushW(IY);
-					break;
-				case 0xE9: // jp (iy)
-				    PC = IY;
-					break;
-				case 0xF9: // ld sp,iy
-				    SP = IY;
-					break;
-			    default:
+#undef IXY
+				default:
 					throw lib::stringf("Unknown instruction $FD%02X !", ins);
 			}
 			break;
-		case 0xFE: // cp d8
-			t8 = A();
-			subA(loadB());
-			A() = t8;
-			break;
-		case 0xFF: // rst 38h
-			call(0x0038);
-			break;
 		default:
 			throw lib::stringf("Unknown instruction $%02X !", ins);
 	}
+#undef MXT_CASE
+}
+
+// # --------------------------------------------------------------------------- 
+// # Block cache
+
+void Z80::executeBlock(void)
+{
+	const BlockCache::MicroOp *op = cache_.next(PC);
+
+	if(!op)
+	{
+		op = cache_.append(decode(PC), tracker_);
+	}
+
+	// the handler may invalidate its own block
+	op_fn fn = op->fn;
+	byte_t ins = op->ins;
+	uint8_t t8 = op->t8;
+
+	PC = op->pc + op->len;
+	cycles_ += op->cycles;
+
+	fn(*this, ins, t8);
+}
+
+// Resolves the prefixes of the instruction at 'a' the same way op_prefix
+// does at run time.
+BlockCache::MicroOp Z80::decode(uint16_t a) const
+{
+	BlockCache::MicroOp op;
+	uint t = OPS_MAIN;
+	byte_t ins = mem_.peek(a);
+
+	op.pc = a;
+	op.t8 = 0;
+	op.len = 1;
+	op.cycles = Cycles::MAIN[ins];
+
+	switch(ins)
+	{
+		case 0xCB: t = OPS_CB; break;
+		case 0xDD: t = OPS_DD; break;
+		case 0xED: t = OPS_ED; break;
+		case 0xFD: t = OPS_FD; break;
+	}
+
+	if(t != OPS_MAIN)
+	{
+		ins = mem_.peek(a + 1);
+		op.len = 2;
+		op.cycles += (t == OPS_CB ? Cycles::CB : t == OPS_ED ? Cycles::ED : Cycles::XY)[ins];
+
+		if(t != OPS_CB && t != OPS_ED && ins == 0xCB)
+		{
+			t = (t == OPS_DD ? OPS_DDCB : OPS_FDCB);
+			op.t8 = mem_.peek(a + 2);
+			ins = mem_.peek(a + 3);
+			op.len = 4;
+			op.cycles += Cycles::XYCB[ins];
+		}
+	}
+
+	op.fn = ops_[t][ins];
+	op.ins = ins;
+	op.table = t;
+
+	return op;
+}
+
+// # --------------------------------------------------------------------------- 
+// # Recompiler
+
+// Runs the compiled block starting at PC if there is one that fits into
+// 'n' instructions and 't' T-states, compiling it once it got hot.
+// Returns the number of instructions executed, 0 if the caller has to
+// interpret the next instruction instead.
+uint Z80::executeNative(uint n, uint64_t t)
+{
+	// native blocks don't record history, traces or profiles, and don't
+	// stop for watchpoints
+	if(halted_ || interrupted_ || rewind_.p || profile_.p || watches_.any())
+	{
+		return 0;
+	}
+
+#ifdef Z80_TRACE
+	if(tracer_.p)
+	{
+		return 0;
+	}
+#endif
+
+	BlockCache::Block *b = cache_.find(PC);
+
+	if(!b || cache_.isRecording(b))
+	{
+		return 0;
+	}
+
+	if(!b->compiled)
+	{
+		if(++b->hits < Recompiler::THRESHOLD)
+		{
+			return 0;
+		}
+
+		compile(*b);
+
+		// a full arena drops every block, this one included
+		if(!(b = cache_.find(PC)))
+		{
+			return 0;
+		}
+	}
+
+	if(!b->native || b->nativeOps > n || b->worst >= t)
+	{
+		return 0;
+	}
+
+	if(breaks_.any())
+	{
+		for(uint i = 1 ; i < b->nativeOps ; ++i)
+		{
+			if(breaks_.test(b->ops[i].pc))
+			{
+				return 0;
+			}
+		}
+	}
+
+	cache_.leave();
+	abort_ = false;
+
+	n = b->native(this);
+	native_ += n;
+
+	return n;
+}
+
+// Compiles the block up to its first instruction that may throw or talk
+// to a peripheral; those are left to the interpreter. A halt ends the
+// compiled part, since run() has to stop right after it.
+void Z80::compile(BlockCache::Block& b)
+{
+	uint n = 0, worst = 0;
+
+	b.compiled = true;
+
+	if(!Recompiler::isSupported())
+	{
+		return;
+	}
+
+	while(n < b.ops.size() && isNative(b.ops[n]))
+	{
+		worst += b.ops[n].cycles + Cycles::CALL_TAKEN;
+
+		if(b.ops[n++].fn == ops_[OPS_MAIN][0x76])
+		{
+			break;
+		}
+	}
+
+	if(!n)
+	{
+		return;
+	}
+
+	Recompiler::Layout l;
+
+	l.pc = (uint8_t *) &PC - (uint8_t *) this;
+	l.cycles = (uint8_t *) &cycles_ - (uint8_t *) this;
+	l.abort = (uint8_t *) &abort_ - (uint8_t *) this;
+
+	if(!(b.native = jit_.compile(b.ops.data(), n, l)))
+	{
+		flush();
+
+		return;
+	}
+
+	b.nativeOps = n;
+	b.worst = worst;
+}
+
+bool Z80::isNative(const BlockCache::MicroOp& op)
+{
+	static const op_fn unknown[OPS_COUNT] =
+	{
+		&Z80::thunk<&Z80::op_unknown<OPS_MAIN>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_CB>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_ED>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_DD>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_FD>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_DDCB>>,
+		&Z80::thunk<&Z80::op_unknown<OPS_FDCB>>
+	};
+
+	if(op.fn == unknown[op.table])
+	{
+		return false;
+	}
+
+	switch(op.table)
+	{
+		case OPS_MAIN:
+		case OPS_DD:
+		case OPS_FD:
+			return op.ins != 0xD3 && op.ins != 0xDB;            // out (n),a / in a,(n)
+		case OPS_ED:
+			return (op.ins & 0xC6) != 0x40 && (op.ins & 0xE6) != 0xA2; // in/out (c), block i/o
+		default:
+			return true;
+	}
+}
+
+bool Z80::sameState(const Z80& z) const
+{
+	return AF == z.AF && BC == z.BC && DE == z.DE && HL == z.HL
+		&& AFp == z.AFp && BCp == z.BCp && DEp == z.DEp && HLp == z.HLp
+		&& IR == z.IR && IX == z.IX && IY == z.IY && SP == z.SP && PC == z.PC
+		&& int_ == z.int_ && halted_ == z.halted_ && interrupted_ == z.interrupted_
+		&& cycles_ == z.cycles_
+		&& mem_.sameRAM(z.mem_);
+}
+
+// # --------------------------------------------------------------------------- 
+// # Table dispatch
+
+Z80::op_fn Z80::ops_[OPS_COUNT][0x100];
+
+void Z80::initOps(void)
+{
+	std::fill(ops_[OPS_MAIN], ops_[OPS_MAIN] + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_MAIN>>);
+	std::fill(ops_[OPS_CB],   ops_[OPS_CB]   + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_CB>>);
+	std::fill(ops_[OPS_ED],   ops_[OPS_ED]   + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_ED>>);
+	std::fill(ops_[OPS_DD],   ops_[OPS_DD]   + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_DD>>);
+	std::fill(ops_[OPS_FD],   ops_[OPS_FD]   + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_FD>>);
+	std::fill(ops_[OPS_DDCB], ops_[OPS_DDCB] + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_DDCB>>);
+	std::fill(ops_[OPS_FDCB], ops_[OPS_FDCB] + 0x100, &Z80::thunk<&Z80::op_unknown<OPS_FDCB>>);
+
+#define Z80_OP_MAIN(op, ...) ops_[OPS_MAIN][op] = &Z80::thunk<&Z80::op_MAIN_##op>;
+#define Z80_OP_CB(op, ...)   ops_[OPS_CB][op]   = &Z80::thunk<&Z80::op_CB_##op>;
+#define Z80_OP_ED(op, ...)   ops_[OPS_ED][op]   = &Z80::thunk<&Z80::op_ED_##op>;
+#define Z80_OP_XY(op, ...)   ops_[OPS_DD][op]   = &Z80::thunk<&Z80::op_DD_##op>;   ops_[OPS_FD][op]   = &Z80::thunk<&Z80::op_FD_##op>;
+#define Z80_OP_XYCB(op, ...) ops_[OPS_DDCB][op] = &Z80::thunk<&Z80::op_DDCB_##op>; ops_[OPS_FDCB][op] = &Z80::thunk<&Z80::op_FDCB_##op>;
+#include "Opcodes.h"
+
+	ops_[OPS_MAIN][0xCB] = &Z80::thunk<&Z80::op_prefix<OPS_CB>>;
+	ops_[OPS_MAIN][0xDD] = &Z80::thunk<&Z80::op_prefix<OPS_DD>>;
+	ops_[OPS_MAIN][0xED] = &Z80::thunk<&Z80::op_prefix<OPS_ED>>;
+	ops_[OPS_MAIN][0xFD] = &Z80::thunk<&Z80::op_prefix<OPS_FD>>;
+	ops_[OPS_DD][0xCB]   = &Z80::thunk<&Z80::op_prefix<OPS_DDCB>>;
+	ops_[OPS_FD][0xCB]   = &Z80::thunk<&Z80::op_prefix<OPS_FDCB>>;
+}
+
+// Fetches the opcode following a prefix and dispatches it through table T.
+// For the DDCB/FDCB forms the displacement comes first and is handed to the
+// handler as t8.
+template<uint T>
+void Z80::op_prefix(byte_t ins, uint8_t t8)
+{
+	static const uint8_t * const timing[OPS_COUNT] =
+		{ Cycles::MAIN, Cycles::CB, Cycles::ED, Cycles::XY, Cycles::XY, Cycles::XYCB, Cycles::XYCB };
+
+	if(T == OPS_DDCB || T == OPS_FDCB)
+	{
+		t8 = loadB();
+	}
+
+	ins = loadB();
+	cycles_ += timing[T][ins];
+
+	ops_[T][ins](*this, ins, t8);
+}
+
+template<uint T>
+void Z80::op_unknown(byte_t ins, uint8_t t8)
+{
+	static const char * const prefix[OPS_COUNT] = { "", "CB", "ED", "DD", "FD", "DDCB", "FDCB" };
+
+	throw lib::stringf("Unknown instruction $%s%02X !", prefix[T], ins);
+}
+
+#define MXT_HANDLER(name, ...) \
+void Z80::name(byte_t ins, uint8_t t8) { uint16_t t16; (void) t16; __VA_ARGS__ }
+#define Z80_OP_MAIN(op, ...) MXT_HANDLER(op_MAIN_##op, __VA_ARGS__)
+#define Z80_OP_CB(op, ...)   MXT_HANDLER(op_CB_##op, __VA_ARGS__)
+#define Z80_OP_ED(op, ...)   MXT_HANDLER(op_ED_##op, __VA_ARGS__)
+#include "Opcodes.h"
+#define IXY IX
+#define Z80_OP_XY(op, ...)   MXT_HANDLER(op_DD_##op, __VA_ARGS__)
+#define Z80_OP_XYCB(op, ...) MXT_HANDLER(op_DDCB_##op, __VA_ARGS__)
+#include "Opcodes.h"
+#undef IXY
+#define IXY IY
+#define Z80_OP_XY(op, ...)   MXT_HANDLER(op_FD_##op, __VA_ARGS__)
+#define Z80_OP_XYCB(op, ...) MXT_HANDLER(op_FDCB_##op, __VA_ARGS__)
+#include "Opcodes.h"
+#undef IXY
+#undef MXT_HANDLER
+
+// Executes up to n instructions in one go. Stops early when the cpu halts,
+// when an interrupt got raised by the last instruction, when it hit a
+// watchpoint or when there is a breakpoint at the next PC. The
+// instruction at the PC run was called with is always executed, so
+// resuming from a breakpoint doesn't immediately trigger it again.
+Z80::Stop Z80::run(uint n)
+{
+	watches_.resume();
+
+	return (breaks_.any() || watches_.any()) ? runBatch<true>(n) : runBatch<false>(n);
+}
+
+// Without breakpoints and watchpoints (B is false) the loops don't check
+// for either.
+template<bool B>
+Z80::Stop Z80::runBatch(uint n)
+{
+	while(n)
+	{
+		if(halted_ && !(int_ && interrupted_))
+		{
+			return Stop::HALT;
+		}
+
+		uint k = (dispatch_ == Dispatch::JIT) ? executeNative(n, events_.next() - cycles_) : 0;
+
+		if(!k)
+		{
+			execute();
+			k = 1;
+		}
+		else
+		{
+			fire();
+		}
+
+		n -= k;
+
+		// a watch hit on the instruction that raised an interrupt must not
+		// be lost, the latch is cleared on the next entry
+		if(B && watches_.isHit())
+		{
+			return Stop::WATCH;
+		}
+
+		if(int_ && interrupted_)
+		{
+			return Stop::INTERRUPT;
+		}
+
+		if(B && breaks_.test(PC) && breaks_.check(*this, PC))
+		{
+			return Stop::BREAK;
+		}
+	}
+
+	return Stop::BUDGET;
+}
+
+// Like run, but the budget is given in T-states. A halted cpu idles
+// until the next device event, just like the real chip would keep
+// executing nops until the next interrupt, and stops with HALT if none
+// wakes it up within the budget.
+Z80::Stop Z80::runFor(uint64_t t)
+{
+	watches_.resume();
+
+	return (breaks_.any() || watches_.any()) ? runCycles<true>(t) : runCycles<false>(t);
 }
 
-bool Z80::parityEven(uint8_t v)
+template<bool B>
+Z80::Stop Z80::runCycles(uint64_t t)
 {
-	v ^= v >> 4;
-	v ^= v >> 2;
-	v ^= v >> 1;
-	return (~v) & 1;
+	uint64_t end = cycles_ + t;
+
+	while(cycles_ < end)
+	{
+		if(halted_ && !(int_ && interrupted_))
+		{
+			cycles_ = std::min(end, events_.next());
+			fire();
+
+			if(cycles_ >= end && halted_ && !(int_ && interrupted_))
+			{
+				return Stop::HALT;
+			}
+
+			continue;
+		}
+
+		if(dispatch_ != Dispatch::JIT || !executeNative(-1, std::min(end, events_.next()) - cycles_))
+		{
+			execute();
+		}
+		else
+		{
+			fire();
+		}
+
+		// a watch hit on the instruction that raised an interrupt must not
+		// be lost, the latch is cleared on the next entry
+		if(B && watches_.isHit())
+		{
+			return Stop::WATCH;
+		}
+
+		if(int_ && interrupted_)
+		{
+			return Stop::INTERRUPT;
+		}
+
+		if(B && breaks_.test(PC) && breaks_.check(*this, PC))
+		{
+			return Stop::BREAK;
+		}
+	}
+
+	return Stop::BUDGET;
 }
 
 void Z80::addHL(uint16_t v, bool use_c)
@@ -2449,60 +923,29 @@ void Z80::subHL(uint16_t v, bool use_c)
 
 void Z80::addA(uint8_t v, bool use_c)
 {
-	uint8_t a = A();
-	uint8_t cIn, cOut;
-
 	uint cf = (use_c && (F() & FLAG_C)) ? 1 : 0;
-	uint8_t t = (A() & 0x0F) + (v & 0x0F) + cf;
 
-	if(cf)
-	{
-		cOut = (a >= 0xff - v) ? 1 : 0;
-		A() = a + v + 1;
-	}
-	else
-	{
-		cOut = (a > 0xff - v) ? 1 : 0;
-		A() = a + v;
-	}
-	
-	cIn = A() ^ a ^ v;
-	cIn = (cIn >> 7) ^ cOut;
-	
-	set_flags(FLAG_ALL,
-		cIn,
-		A() & FLAG_S,
-		A() == 0,
-		t & FLAG_H,
-		0,
-		cOut);
+	F() = (F() & Flags::KEEP) | Flags::ADD[Flags::index(cf, A(), v)];
+	A() += v + cf;
 }
 
 void Z80::subA(uint8_t v, bool use_c)
 {
-	if(!use_c) F() &= ~FLAG_C;
+	uint cf = (use_c && (F() & FLAG_C)) ? 1 : 0;
 
-	F() ^= FLAG_C;
-	addA(~v, true);
-	F() ^= FLAG_C;
-	F() |= FLAG_N;
+	F() = (F() & Flags::KEEP) | Flags::SUB[Flags::index(cf, A(), v)];
+	A() -= v + cf;
 }
 
 void Z80::logicA(uint8_t v, bool set_h)
 {
 	A() = v;
-	set_flags(FLAG_ALL,
-		parityEven(v),
-		v & FLAG_S,
-		v == 0,
-		set_h,
-		0,
-		0);
+	F() = (F() & Flags::KEEP) | Flags::SZP[v] | (set_h ? FLAG_H : 0);
 }
 
 void Z80::pushB(uint8_t b)
 {
-	ram_[--SP] = b;
+	storeB(--SP, b);
 }
 
 void Z80::pushW(uint16_t bc)
@@ -2513,7 +956,7 @@ void Z80::pushW(uint16_t bc)
 
 uint8_t Z80::popB(void)
 {
-	return ram_[SP++];
+	return loadB(SP++);
 }
 
 uint16_t Z80::popW(void)
@@ -2523,7 +966,7 @@ uint16_t Z80::popW(void)
 
 void Z80::jr(void)
 {
-	uint8_t d = ram_[PC++];
+	uint8_t d = loadB();
 
 	if(d & FLAG_S)
 		PC -= (~d & 0xff) + 1;
@@ -2533,34 +976,58 @@ void Z80::jr(void)
 
 void Z80::out(uint8_t port, uint8_t data)
 {
-	auto p = periphs_.find(port >> 4);
+	Port& p(ports_[port]);
+
+	++epoch_;
 
-	if(p != periphs_.end())
+	if(watches_.isWatchedPort(port, Watchpoints::WRITE))
+	{
+		watches_.check(*this, true, port, data, Watchpoints::WRITE);
+	}
+
+	if(p.handler && handlers_[p.handler - 1].out)
+	{
+		handlers_[p.handler - 1].out(port, data);
+	}
+	else if(p.periph)
 	{
-		p->second->write(port & 0x0F, data);
+		p.periph->write(port - p.base, data);
 	}
 }
 
 uint8_t Z80::in(uint8_t port)
 {
-	auto p = periphs_.find(port >> 4);
+	Port& p(ports_[port]);
+	uint8_t v = 0;
+
+	++epoch_;
+
+	if(p.handler && handlers_[p.handler - 1].in)
+	{
+		v = handlers_[p.handler - 1].in(port);
+	}
+	else if(p.periph)
+	{
+		v = p.periph->read(port - p.base);
+	}
 
-	if(p != periphs_.end())
+	if(watches_.isWatchedPort(port, Watchpoints::READ))
 	{
-		return p->second->read(port & 0x0F);
+		watches_.check(*this, true, port, v, Watchpoints::READ);
 	}
 
-	return 0;
+	return v;
 }
 
+// Fetches from PC don't show up in traces.
 uint8_t Z80::loadB(void)
 {
-	return loadB(PC++);
+	return mem_.read(PC++);
 }
 
 uint16_t Z80::loadW(void)
 {
-	uint16_t r = loadW(PC);
+	uint16_t r = mem_.read(PC) | (mem_.read(PC + 1) << 8);
 
 	PC += 2;
 
@@ -2569,7 +1036,14 @@ uint16_t Z80::loadW(void)
 
 uint8_t Z80::loadB(uint16_t a)
 {
-	return ram_[a];
+	uint8_t v = mem_.read(a);
+
+	if(watches_.isWatched(a, Watchpoints::READ)) watches_.check(*this, false, a, v, Watchpoints::READ);
+#ifdef Z80_TRACE
+	if(tracer_.p) tracer_.p->access(a, v, false);
+#endif
+
+	return v;
 }
 
 uint16_t Z80::loadW(uint16_t a)
@@ -2579,7 +1053,13 @@ uint16_t Z80::loadW(uint16_t a)
 
 void Z80::storeB(uint16_t a, uint8_t v)
 {
-	ram_[a] = v;
+	if(rewind_.p && mem_.isDirect(a)) rewind_.p->write(a, mem_.peek(a));
+	if(watches_.isWatched(a, Watchpoints::WRITE)) watches_.check(*this, false, a, v, Watchpoints::WRITE);
+#ifdef Z80_TRACE
+	if(tracer_.p) tracer_.p->access(a, v, true);
+#endif
+	invalidate(a);
+	mem_.write(a, v);
 }
 
 void Z80::storeW(uint16_t a, uint16_t v)
@@ -2588,6 +1068,37 @@ void Z80::storeW(uint16_t a, uint16_t v)
 	storeB(a + 1, v >> 8);
 }
 
+void Z80::jr_if(bool c)
+{
+	if(c)
+	{
+		jr();
+		cycles_ += Cycles::JR_TAKEN;
+	}
+	else
+	{
+		++PC;
+	}
+}
+
+void Z80::call_if(bool c, uint16_t a)
+{
+	if(c)
+	{
+		call(a);
+		cycles_ += Cycles::CALL_TAKEN;
+	}
+}
+
+void Z80::ret_if(bool c)
+{
+	if(c)
+	{
+		ret();
+		cycles_ += Cycles::RET_TAKEN;
+	}
+}
+
 void Z80::call(uint16_t a)
 {
 	pushW(PC);
@@ -2609,7 +1120,7 @@ void Z80::rotate_left(uint8_t& r, uint bit0)
 		case BIT_CARRY: r |= F() & FLAG_C ? 1 : 0; break;
 		case BIT_L: r |= 1; break;
 	}
-	set_flags(FLAG_ALL, parityEven(r), r & FLAG_S, r == 0, 0, 0, c);
+	F() = (F() & Flags::KEEP) | Flags::SZP[r] | (c ? FLAG_C : 0);
 }
 
 void Z80::rotate_right(uint8_t& r, uint bit7)
@@ -2622,7 +1133,7 @@ void Z80::rotate_right(uint8_t& r, uint bit7)
 		case BIT_CARRY: r |= F() & FLAG_C ? 0x80 : 0; break;
 		case BIT_A: r |= r & 0x40 ? 0x80 : 0; break;
 	}
-	set_flags(FLAG_ALL, parityEven(r), r & FLAG_S, r == 0, 0, 0, c);
+	F() = (F() & Flags::KEEP) | Flags::SZP[r] | (c ? FLAG_C : 0);
 }
 
 void Z80::rlca(void)
@@ -2681,29 +1192,17 @@ void Z80::daa(void)
 		F() &= ~FLAG_C;
 	}
 
-	F() = parityEven(A()) ? (F() | FLAG_PV) : (F() & ~FLAG_PV);
+	F() = (F() & ~FLAG_PV) | (Flags::SZP[A()] & FLAG_PV);
 }
 
 void Z80::set_inc_flags(uint8_t v)
 {
-	set_flags(FLAG_ALL & ~FLAG_C,
-		v == 0x80,	   // P/V
-		v & FLAG_S,	  // S
-		v == 0,		  // Z
-		(v & 0x0F) == 0, // H
-		0,			   // N
-		0);			  // C
+	F() = (F() & (Flags::KEEP | FLAG_C)) | Flags::INC[v];
 }
 
 void Z80::set_dec_flags(uint8_t v)
 {
-	set_flags(FLAG_ALL & ~FLAG_C,
-		v == 0x7F,		  // P/V
-		v & FLAG_S,		 // S
-		v == 0,			 // Z
-		(v & 0x0F) == 0x0F, // H
-		1,				  // N
-		0);				 // C
+	F() = (F() & (Flags::KEEP | FLAG_C)) | Flags::DEC[v];
 }
 
 uint16_t Z80::getOff(uint16_t a, uint8_t v)
@@ -2713,51 +1212,37 @@ uint16_t Z80::getOff(uint16_t a, uint8_t v)
 
 void Z80::set_flags(uint flags, uint f_pv, uint f_s, uint f_z, uint f_h, uint f_n, uint f_c)
 {
-	if(flags & FLAG_PV)
-	{
-		F() = f_pv ? (F() | FLAG_PV) : (F() & ~FLAG_PV);
-	}
-
-	if(flags & FLAG_S)
-	{
-		F() = f_s ? (F() | FLAG_S) : (F() & ~FLAG_S);
-	}
+	uint8_t v = (f_pv ? FLAG_PV : 0)
+	          | (f_s  ? FLAG_S  : 0)
+	          | (f_z  ? FLAG_Z  : 0)
+	          | (f_h  ? FLAG_H  : 0)
+	          | (f_n  ? FLAG_N  : 0)
+	          | (f_c  ? FLAG_C  : 0);
 
-	if(flags & FLAG_Z)
-	{
-		F() = f_z ? (F() | FLAG_Z) : (F() & ~FLAG_Z);
-	}
+	flags &= ~Flags::KEEP;
 
-	if(flags & FLAG_H)
-	{
-		F() = f_h ? (F() | FLAG_H) : (F() & ~FLAG_H);
-	}
+	F() = (F() & ~flags) | (v & flags);
+}
 
-	if(flags & FLAG_N)
-	{
-		F() = f_n ? (F() | FLAG_N) : (F() & ~FLAG_N);
-	}
+std::string Z80::disassemble(uint16_t addr) const
+{
+	uint8_t buf[4];
 
-	if(flags & FLAG_C)
+	for(uint i = 0 ; i < 4 ; ++i)
 	{
-		F() = f_c ? (F() | FLAG_C) : (F() & ~FLAG_C);
+		buf[i] = mem_.peek(addr + i);
 	}
-}
 
-std::string Z80::disassemble(uint16_t addr) const
-{
-	return z80::disassemble(&ram_[addr]).literal;
+	return z80::disassemble(buf).literal;
 }
 
 void Z80::clear(void)
 {
 	AF = AFp = BC = BCp = DE = DEp = HL = HLp = IR = IX = IY = SP = PC = 0;
-	for(uint i = 0 ; i < 0x10000 ; ++i)
-	{
-		ram_[i] = 0;
-	}
+	flush();
+	mem_.clear();
+	++epoch_;
 }
 
 }
 
-
@@ -1,15 +1,28 @@
 #ifndef Z80_H
 #define Z80_H
 
-#include <map>
 #include <iostream>
+#include <vector>
+#include <functional>
 #include <stdint.h>
 
 #include "Peripheral.h"
 #include "Program.h"
+#include "Memory.h"
+#include "Snapshot.h"
+#include "Events.h"
+#include "Breakpoints.h"
+#include "Watchpoints.h"
+#include "WriteTracker.h"
+#include "BlockCache.h"
+#include "Recompiler.h"
 
 namespace z80
 {
+	class Rewind;
+	class Tracer;
+	class Profiler;
+
 	class Z80
 	{
 		public:
@@ -31,17 +44,96 @@ namespace z80
 			static const uint BIT_A = 2;
 			static const uint BIT_L = 3;
 
+			enum class Stop
+			{
+				BUDGET,
+				HALT,
+				BREAK,
+				WATCH,
+				INTERRUPT
+			};
+
+			enum class Dispatch
+			{
+				SWITCH,
+				TABLE,
+				BLOCK,
+				JIT
+			};
+
+			struct Registers
+			{
+				uint16_t AF, AFp, BC, BCp, DE, DEp, HL, HLp;
+				uint16_t IR, IX, IY, SP, PC;
+				bool iff, halted, interrupted;
+				uint64_t cycles;
+			};
+
+			typedef std::function<uint8_t(port_t)> in_fn;
+			typedef std::function<void(port_t, uint8_t)> out_fn;
+
+#ifdef Z80_DISPATCH_SWITCH
+			static const Dispatch DISPATCH = Dispatch::SWITCH;
+#else
+			static const Dispatch DISPATCH = Dispatch::TABLE;
+#endif
+
+			// the clock of the board the guest programs are written for
+			static const uint64_t CLOCK = 4000000;
+
+#ifdef Z80_TRACE
+			static const bool TRACING = true;
+#else
+			static const bool TRACING = false;
+#endif
+
 		public:
+			Z80( );
 			void printStatus(std::ostream&);
 			void printRAM(std::ostream&, addr_t, size_t);
 			void reset( );
+			void save(Snapshot&) const;
+			void restore(Snapshot&);
 			void loadRAM(addr_t, const Program&);
 			void registerPeripheral(port_t, Peripheral&);
+			void registerPeripheral(port_t, uint, Peripheral&);
+			void registerPort(port_t, in_fn, out_fn);
+			void clearPeripherals( );
 			void execute( );
+			uint step( );
+			void execute(Dispatch);
+			Stop run(uint);
+			Stop runFor(uint64_t);
+			uint64_t getCycles( ) const { return cycles_; }
+			void setDispatch(Dispatch);
+			Dispatch getDispatch( ) const { return dispatch_; }
+			uint getCachedBlocks( ) const { return cache_.size(); }
+			uint64_t getNativeInstructions( ) const { return native_; }
+			void invalidate(uint16_t a) { if(tracker_.isTracked(a)) { tracker_.write(a); abort_ = true; } }
+			WriteTracker& getWriteTracker( ) { return tracker_; }
+			Events& getEvents( ) { return events_; }
+			bool sameState(const Z80&) const;
+			Breakpoints& getBreakpoints( ) { return breaks_; }
+			const Breakpoints& getBreakpoints( ) const { return breaks_; }
+			Watchpoints& getWatchpoints( ) { return watches_; }
+			const Watchpoints& getWatchpoints( ) const { return watches_; }
+			void setRewind(Rewind *r) { rewind_.p = r; }
+			void replay(uint);
+			uint64_t getEpoch( ) const { return epoch_; }
+			void setTracer(Tracer *t) { tracer_.p = t; }
+			void setProfiler(Profiler *p) { profile_.p = p; }
+			inline Registers getRegisters( ) const;
+			inline void setRegisters(const Registers&);
+			void poke(uint16_t a, uint8_t v) { invalidate(a); mem_.write(a, v); ++epoch_; }
 			bool isHalted( ) const { return halted_; }
-			void restart( ) { halted_ = false; }
-			void interrupt( ) { if(int_) interrupted_ = true; }
-			uint8_t& RAM(uint16_t a) { return ram_[a]; }
+			void restart( ) { halted_ = false; ++epoch_; }
+			void interrupt( ) { if(int_) { interrupted_ = true; ++epoch_; } }
+			uint8_t peek(uint16_t a) const { return mem_.peek(a); }
+			const Memory& getMemory( ) const { return mem_; }
+			void mapRAM(uint, uint8_t *);
+			void mapROM(uint, const uint8_t *);
+			void mapIO(uint, Memory::read_fn, Memory::write_fn);
+			void unmap(uint);
 			uint16_t getPC( ) const { return PC; }
 			uint16_t getSP( ) const { return SP; }
 			uint16_t getAF( ) const { return AF; }
@@ -54,14 +146,14 @@ namespace z80
 			uint16_t getHLp( ) const { return HLp; }
 			uint16_t getIX( ) const { return IX; }
 			uint16_t getIY( ) const { return IY; }
-			void setPC(uint16_t v) { PC = v; }
-			void setSP(uint16_t v) { SP = v; }
-			void setAF(uint16_t v) { AF = v; }
-			void setBC(uint16_t v) { BC = v; }
-			void setDE(uint16_t v) { DE = v; }
-			void setHL(uint16_t v) { HL = v; }
-			void setIX(uint16_t v) { IX = v; }
-			void setIY(uint16_t v) { IY = v; }
+			void setPC(uint16_t v) { PC = v; ++epoch_; }
+			void setSP(uint16_t v) { SP = v; ++epoch_; }
+			void setAF(uint16_t v) { AF = v; ++epoch_; }
+			void setBC(uint16_t v) { BC = v; ++epoch_; }
+			void setDE(uint16_t v) { DE = v; ++epoch_; }
+			void setHL(uint16_t v) { HL = v; ++epoch_; }
+			void setIX(uint16_t v) { IX = v; ++epoch_; }
+			void setIY(uint16_t v) { IY = v; ++epoch_; }
 			bool getFlagS( ) const { return AF & FLAG_S; }
 			bool getFlagZ( ) const { return AF & FLAG_Z; }
 			bool getFlagH( ) const { return AF & FLAG_H; }
@@ -71,11 +163,48 @@ namespace z80
 			std::string disassemble(uint16_t) const;
 			void clear( );
 		private:
+			typedef void (*op_fn)(Z80&, byte_t, uint8_t);
+			template<void (Z80::*F)(byte_t, uint8_t)> static void thunk(Z80& z, byte_t i, uint8_t t) { (z.*F)(i, t); }
+
+			enum
+			{
+				OPS_MAIN,
+				OPS_CB,
+				OPS_ED,
+				OPS_DD,
+				OPS_FD,
+				OPS_DDCB,
+				OPS_FDCB,
+				OPS_COUNT
+			};
+
+			static void initOps( );
+			void dispatch(byte_t);
+			void executeBlock( );
+			void flush( ) { cache_.clear(); jit_.reset(); }
+			void fire( ) { if(cycles_ >= events_.next()) { events_.run(cycles_); ++epoch_; } }
+			void remap(uint);
+			template<bool B> Stop runBatch(uint);
+			template<bool B> Stop runCycles(uint64_t);
+			uint executeNative(uint, uint64_t);
+			void compile(BlockCache::Block&);
+			static bool isNative(const BlockCache::MicroOp&);
+			BlockCache::MicroOp decode(uint16_t) const;
+			template<uint T> void op_prefix(byte_t, uint8_t);
+			template<uint T> void op_unknown(byte_t, uint8_t);
+#define Z80_OP_MAIN(op, ...) void op_MAIN_##op(byte_t, uint8_t);
+#define Z80_OP_CB(op, ...)   void op_CB_##op(byte_t, uint8_t);
+#define Z80_OP_ED(op, ...)   void op_ED_##op(byte_t, uint8_t);
+#define Z80_OP_XY(op, ...)   void op_DD_##op(byte_t, uint8_t); void op_FD_##op(byte_t, uint8_t);
+#define Z80_OP_XYCB(op, ...) void op_DDCB_##op(byte_t, uint8_t); void op_FDCB_##op(byte_t, uint8_t);
+#include "Opcodes.h"
+
 			void pushB(uint8_t);
 			void pushW(uint16_t);
 			uint8_t popB( );
 			uint16_t popW( );
 			void jr();
+			void jr_if(bool);
 			void out(uint8_t, uint8_t);
 			uint8_t in(uint8_t);
 			uint8_t loadB( );
@@ -86,11 +215,12 @@ namespace z80
 			void storeW(uint16_t, uint16_t);
 			void call(uint16_t);
 			void ret( );
+			void call_if(bool, uint16_t);
+			void ret_if(bool);
 			uint16_t getOff(uint16_t, uint8_t);
 			void set_inc_flags(uint8_t);
 			void set_dec_flags(uint8_t);
 			void set_flags(uint, uint /*P/V*/, uint /*S*/, uint /*Z*/, uint /*H*/, uint /*N*/, uint /*C*/);
-			bool parityEven(uint8_t);
 			void addHL(uint16_t, bool = false);
 			void subHL(uint16_t, bool = false);
 			void addA(uint8_t, bool = false);
@@ -113,13 +243,74 @@ namespace z80
 			uint8_t& H() { return ((uint8_t *) &HL)[1]; }
 			uint8_t& L() { return ((uint8_t *) &HL)[0]; }
 
+			// A direct handler takes precedence over the peripheral,
+			// which sees the port relative to the start of its range.
+			// Handlers are rare, so they live out of line to keep the
+			// cpu small enough to fork cheaply. 'handler' is one past the
+			// index of the port's handler, and every port may have one.
+			struct Port
+			{
+				Peripheral *periph;
+				port_t base;
+				uint16_t handler;
+			};
+
+			struct Handler
+			{
+				in_fn in;
+				out_fn out;
+			};
+
+			// Copies of the cpu don't record into the original's history,
+			// trace or profile.
+			template<typename T>
+			struct Recorder
+			{
+				Recorder( ) : p(nullptr) { }
+				Recorder(const Recorder&) : p(nullptr) { }
+				Recorder& operator=(const Recorder&) { return *this; }
+				T *p;
+			};
+
 		private:
-			byte_t ram_[0x10000];
+			Memory mem_;
 			uint16_t AF, AFp, BC, BCp, DE, DEp, HL, HLp;
 			uint16_t IR, IX, IY, SP, PC;
-			std::map<port_t, Peripheral *> periphs_;
 			bool int_, halted_, interrupted_;
+			uint64_t cycles_;
+			uint64_t epoch_;
+			Port ports_[0x100];
+			std::vector<Handler> handlers_;
+			Dispatch dispatch_;
+			WriteTracker tracker_;
+			BlockCache cache_;
+			Recompiler jit_;
+			bool abort_;
+			uint64_t native_;
+			Breakpoints breaks_;
+			Watchpoints watches_;
+			Events events_;
+			Recorder<Rewind> rewind_;
+			Recorder<Tracer> tracer_;
+			Recorder<Profiler> profile_;
+
+			static op_fn ops_[OPS_COUNT][0x100];
 	};
+
+	Z80::Registers Z80::getRegisters(void) const
+	{
+		return Registers { AF, AFp, BC, BCp, DE, DEp, HL, HLp, IR, IX, IY, SP, PC, int_, halted_, interrupted_, cycles_ };
+	}
+
+	void Z80::setRegisters(const Registers& r)
+	{
+		AF = r.AF; AFp = r.AFp; BC = r.BC; BCp = r.BCp; DE = r.DE; DEp = r.DEp; HL = r.HL; HLp = r.HLp;
+		IR = r.IR; IX = r.IX; IY = r.IY; SP = r.SP; PC = r.PC;
+		int_ = r.iff; halted_ = r.halted; interrupted_ = r.interrupted;
+		cycles_ = r.cycles;
+		events_.align(cycles_);
+		++epoch_;
+	}
 }
 
 #endif
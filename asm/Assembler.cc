@@ -168,6 +168,8 @@ Assembler::Assembler(const std::string& fn)
 
 		mProgram.data.push_back(entry);
 	}
+
+	mProgram.symbols = mSymbols;
 }
 
 void Assembler::add(meta_t meta, const std::initializer_list<uint8_t>& data)
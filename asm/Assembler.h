@@ -54,6 +54,7 @@ namespace z80
 		{
 			std::vector<entry_t> data;
 			std::vector<error_t> errors;
+			std::map<std::string, uint16_t> symbols;
 		};
 
 		class Tokenizer
@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include "Assembler.h"
+#include "Symbols.h"
 
 using namespace z80;
 
@@ -71,6 +72,33 @@ try
 
 			std::cout << "Wrote " << size << " bytes to file " << argv[2] << "." << std::endl;
 
+			// the labels go next to the binary, for the emulator's profiler
+			std::string sym(Symbols::getPath(argv[2]));
+
+			std::ofstream syms(sym);
+			std::multimap<uint16_t, std::string> byAddr;
+
+			for(const auto& e : p.symbols)
+			{
+				byAddr.insert(std::make_pair(e.second, e.first));
+			}
+
+			for(const auto& e : byAddr)
+			{
+				char b[10];
+				snprintf(b, 10, "$%04X ", (uint)e.first);
+				syms << b << e.second << "\n";
+			}
+
+			if(!syms.good())
+			{
+				std::cerr << "ERR: failed to write symbol file \"" << sym << "\"!" << std::endl;
+
+				return 1;
+			}
+
+			std::cout << "Wrote " << byAddr.size() << " symbols to file " << sym << "." << std::endl;
+
 			return 0;
 		}
 	}